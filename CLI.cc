@@ -42,7 +42,7 @@ void what_to_do(
     else if (command == "-r" || command == "--read") {
         tjson.clear();
         tjfile.readJsonFile(readStoreOrFind);
-        tjson.setJsonStr(tjfile.getJsonStr());
+        tjson.setJsonView(tjfile.getJsonView());
     }
     else if (command == "-s" || command == "--store") {
         tjfile.dumpJsonObj2File(tjson, readStoreOrFind);
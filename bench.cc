@@ -0,0 +1,730 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-20T10:12:31
+ * @lastmod: 2024-07-20T10:12:31
+ * @description: micro benchmarks
+ * @filePath: /cpp-tiny-json/bench.cc
+ * @lastEditor: Laplace825
+ * @ MIT lisence
+ */
+
+#include <chrono>
+#include <regex>
+#include <thread>
+#include <fstream>
+#include <tjson.hpp>
+#include <tjson/tjfile.hpp>
+#include <tjson/tjsonNdjson.hpp>
+
+using namespace lap::tjson;
+
+// run the op for times, return the cost in ms
+template < typename Callable >
+double timeIt(std::size_t times, Callable&& op) {
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < times; ++i) {
+        op();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration< double, std::milli >(end - begin).count();
+}
+
+void report(std::string_view name, double ms) {
+    std::cout << std::format("\033[1;32m{:<32}\033[0m{:>12.3f} ms\n", name, ms);
+}
+
+// the number path before the hand-written lexer, kept for comparison
+TJsonObj regexNumber(const std::string_view json_str, std::size_t& reads) {
+    std::regex number_re{"[-]?[0-9]+(\\.[0-9]*)?([eE][+-]?[0-9]+)?"};
+    std::match_results< std::string_view::const_iterator > sub_match;
+    auto run_end = std::min(
+      json_str.find_first_not_of("+-.0123456789eE", reads), json_str.size());
+    if (std::regex_search(json_str.begin() + reads, json_str.begin() + run_end,
+          sub_match, number_re, std::regex_constants::match_continuous))
+    {
+        auto str = json_str.substr(reads, sub_match.length());
+        reads += str.size();
+        if (auto value = __detail::_ParserScan::tryParse< int >(str)) {
+            return TJsonObj{value.value()};
+        }
+        if (auto value = __detail::_ParserScan::tryParse< double >(str)) {
+            return TJsonObj{value.value()};
+        }
+    }
+    return TJsonObj{};
+}
+
+void benchNumber() {
+    std::cout << "\033[1;32m>>> number lexer\033[0m\n";
+    std::string numbers;
+    for (int i = 0; i < 20000; ++i) {
+        numbers.append(i % 2 ? std::to_string(i * 7 - 350000)
+                             : std::format("{}.{}e-{}", i, i % 97, i % 9));
+        numbers.push_back(' ');
+    }
+    const std::string_view json_str = numbers;
+
+    auto walk = [&](auto&& deal) {
+        return [&, deal]() {
+            for (std::size_t reads = 0; reads < json_str.size(); ++reads) {
+                deal(json_str, reads);
+            }
+        };
+    };
+
+    report("regex_search + from_chars", timeIt(1, walk([](auto str, auto& r) {
+        return regexNumber(str, r);
+    })));
+    __detail::_ParserScan::_ScanContext ctx{};
+    SaxHandlerBase handler;
+    report("scanNumber + from_chars",
+      timeIt(1, walk([&ctx, &handler](auto str, auto& r) {
+          __detail::_TJsonToken::Type state{};
+          __detail::_ParserScan::dealValueNumber(str, state, r, ctx, handler);
+      })));
+}
+
+void benchString() {
+    std::cout << "\033[1;32m>>> string scan\033[0m\n";
+    std::string strings;
+    for (int i = 0; i < 200000; ++i) {
+        strings.append(std::format(
+          R"("message {} from the service, nothing to escape here" )", i));
+    }
+    const char* end = strings.data() + strings.size();
+
+    // stop at every quote like the parser does, count the stops so the
+    // scan is not optimized away
+    volatile std::size_t stops = 0;
+    auto walk = [&](auto&& find) {
+        return [&, find]() {
+            const char* pos = strings.data();
+            while ((pos = find(pos, end)) < end) {
+                stops = stops + 1;
+                ++pos;
+            }
+        };
+    };
+    report("scalar",
+      timeIt(10, walk(__detail::_SimdScan::findStringSpecialScalar)));
+    report("simd", timeIt(10, walk(__detail::_SimdScan::findStringSpecial)));
+}
+
+// records like {"id": 1, "name": "user1", ...} until size_mb
+std::string makeRecords(std::size_t size_mb) {
+    std::string json_str = "{\"records\": [";
+    for (std::size_t i = 0; json_str.size() < size_mb << 20; ++i) {
+        json_str.append(std::format(
+          R"({}{{"id": {}, "name": "user{}", "score": {}.{}, "tags": ["a", )"
+          R"("bb", "ccc"], "ok": true, "nested": {{"x": {}, "y": null}}}})",
+          i ? ", " : "", i, i, i % 100, i % 7, i * 3));
+    }
+    json_str.append("]}");
+    return json_str;
+}
+
+void benchArena(const std::string& json_str) {
+    std::cout << std::format(
+      "\033[1;32m>>> parse + destroy {} MB\033[0m\n", json_str.size() >> 20);
+    report("heap", timeIt(1, [&]() { Parser parser(json_str); }));
+    report("arena", timeIt(1, [&]() {
+        Parser parser(json_str, ParseOptions{.arena = true});
+    }));
+    report("arena + insitu", timeIt(1, [&]() {
+        Parser parser;
+        parser.setOptions(ParseOptions{.arena = true, .insitu = true});
+        parser.setView(json_str);
+    }));
+}
+
+// TJson takes the root of the Parser, the old way copied it out through
+// toMap, which also dumped the whole tree to a string
+void benchConstruct(const std::string& json_str) {
+    std::cout << std::format(
+      "\033[1;32m>>> TJson of {} MB\033[0m\n", json_str.size() >> 20);
+    report("Parser", timeIt(1, [&]() { Parser parser(json_str); }));
+    report("TJson", timeIt(1, [&]() { TJson tj(json_str); }));
+    report("Parser, toMap and copy", timeIt(1, [&]() {
+        Parser parser(json_str);
+        TJsonObj::DictType dict;
+        for (const auto& [key, value] : parser.get().toMap().first) {
+            dict[key] = value;
+        }
+    }));
+    report("Parser, arena", timeIt(1, [&]() {
+        Parser parser(json_str, ParseOptions{.arena = true});
+    }));
+    report("TJson, arena", timeIt(1, [&]() {
+        TJson tj(json_str, ParseOptions{.arena = true});
+    }));
+}
+
+void benchStructuralIndex(const std::string& json_str) {
+    std::cout << std::format("\033[1;32m>>> two stage parse {} MB\033[0m\n",
+      json_str.size() >> 20);
+    std::vector< std::uint32_t > index;
+    double ms = timeIt(1, [&]() {
+        __detail::_SimdScan::buildStructuralIndex(json_str, index);
+    });
+    report("stage 1", ms);
+    std::cout << std::format(
+      "{:<32}{:>12.3f} GB/s\n", "", json_str.size() / ms / 1e6);
+    report("byte by byte", timeIt(1, [&]() { Parser parser(json_str); }));
+    report("structural index", timeIt(1, [&]() {
+        Parser parser(json_str, ParseOptions{.structural_index = true});
+    }));
+}
+
+// the records without the object around them, a root list
+void benchParallel(const std::string& records) {
+    std::string_view list{records};
+    list = list.substr(list.find('['), list.rfind(']') - list.find('[') + 1);
+    std::cout << std::format("\033[1;32m>>> parse a root list of {} MB on "
+                             "threads\033[0m\n",
+      list.size() >> 20);
+    report("split only", timeIt(1, [&]() {
+        __detail::_ParallelParse::splitRoot(list, 1 << 20);
+    }));
+    for (std::size_t threads : {1, 2, 4, 8}) {
+        report(std::format("{} threads", threads), timeIt(1, [&]() {
+            Parser parser;
+            parser.setOptions(ParseOptions{.threads = threads});
+            parser.setView(list);
+        }));
+    }
+}
+
+// counts the values, the sax parse builds nothing
+struct CountHandler : SaxHandlerBase {
+    std::size_t values = 0;
+
+    void onString(std::string_view) { ++values; }
+
+    void onInt64(std::int64_t) { ++values; }
+
+    void onDouble(double) { ++values; }
+
+    void onBool(bool) { ++values; }
+
+    void onNull() { ++values; }
+};
+
+void benchSax(const std::string& json_str) {
+    std::cout << std::format(
+      "\033[1;32m>>> sax vs tree {} MB\033[0m\n", json_str.size() >> 20);
+    CountHandler handler;
+    report("sax", timeIt(1, [&]() { saxParse(json_str, handler); }));
+    report("tree", timeIt(1, [&]() { Parser parser(json_str); }));
+    std::cout << std::format("{:<32}{:>12} values\n", "", handler.values);
+}
+
+void benchStream(const std::string& json_str) {
+    std::cout << std::format(
+      "\033[1;32m>>> stream in 64 KB chunks {} MB\033[0m\n",
+      json_str.size() >> 20);
+    CountHandler handler;
+    report("sax", timeIt(1, [&]() { saxParse(json_str, handler); }));
+    report("stream", timeIt(1, [&]() {
+        StreamParser parser(handler);
+        const std::string_view view = json_str;
+        for (std::size_t pos = 0; pos < view.size(); pos += 1 << 16) {
+            parser.feed(view.substr(pos, 1 << 16));
+        }
+        parser.finish();
+    }));
+}
+
+void benchNdjson(std::size_t size_mb) {
+    std::string lines;
+    for (std::size_t i = 0; lines.size() < size_mb << 20; ++i) {
+        lines.append(std::format(
+          R"({{"id": {}, "name": "user{}", "score": {}.{}, "ok": true}})"
+          "\n",
+          i, i, i % 100, i % 7));
+    }
+    std::cout << std::format(
+      "\033[1;32m>>> ndjson {} MB\033[0m\n", lines.size() >> 20);
+    std::size_t count = 0;
+    auto run = [&](std::size_t threads) {
+        return timeIt(1, [&]() {
+            NdjsonReader(threads).read(
+              lines, [&count](NdjsonRecord&&) { ++count; });
+        });
+    };
+    report("1 thread", run(1));
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    report(std::format("{} threads", threads), run(threads));
+}
+
+void benchFile(const std::string& json_str) {
+    std::cout << std::format(
+      "\033[1;32m>>> read a {} MB file\033[0m\n", json_str.size() >> 20);
+    const auto path = std::filesystem::temp_directory_path() / "tjson.json";
+    std::ofstream(path, std::ios::binary) << json_str;
+
+    // the line by line read before the file was mapped
+    report("getline + append", timeIt(1, [&]() {
+        std::ifstream ifs(path);
+        std::string line, reads;
+        while (std::getline(ifs, line)) reads.append(line);
+    }));
+    TJsonFile file;
+    std::cout.setstate(std::ios::failbit); // mute "reading: ..."
+    double ms = timeIt(1, [&]() { file.readJsonFile(path); });
+    std::cout.clear();
+    report("mmap", ms);
+    report("mmap + parse", timeIt(1, [&]() {
+        Parser parser;
+        parser.setView(file.getJsonView());
+    }));
+    std::filesystem::remove(path);
+}
+
+// the stringstream path before the buffer serializer, kept for comparison
+void streamValue(std::ostream& os, const TJsonObj& obj) {
+    std::visit(
+      [&os](const auto& arg) {
+          using T = std::decay_t< decltype(arg) >;
+          if constexpr (std::is_same_v< T, std::monostate >) {
+              os << "null";
+          }
+          else if constexpr (std::is_same_v< T, TJsonObj::StringType > ||
+                             std::is_same_v< T, std::string_view >)
+          {
+              os << std::format("\"{}\"", arg);
+          }
+          else if constexpr (std::is_same_v< T, bool >) {
+              os << (arg ? "true" : "false");
+          }
+          else if constexpr (std::is_same_v< T, double >) {
+              os << arg;
+          }
+          else if constexpr (std::is_arithmetic_v< T >) {
+              os << std::to_string(arg);
+          }
+          else if constexpr (std::is_same_v< T, TJsonObj::ListType >) {
+              os << "[";
+              for (std::size_t i = 0; i < arg.size(); ++i) {
+                  streamValue(os, arg[i]);
+                  if (i + 1 < arg.size()) os << ", ";
+              }
+              os << "]";
+          }
+          else if constexpr (std::is_same_v< T, TJsonObj::DictType >) {
+              os << "{";
+              for (auto it = arg.cbegin(); it != arg.cend(); ++it) {
+                  os << std::format("\"{}\": ", it->first);
+                  streamValue(os, it->second);
+                  if (std::next(it) != arg.cend()) os << ", ";
+              }
+              os << "}";
+          }
+          else {
+              os << arg.str;
+          }
+      },
+      obj.get());
+}
+
+void benchSerialize(const std::string& json_str) {
+    Parser parser(json_str);
+    std::cout << std::format(
+      "\033[1;32m>>> serialize {} MB\033[0m\n", json_str.size() >> 20);
+    report("stringstream", timeIt(1, [&]() {
+        std::stringstream oss;
+        streamValue(oss, parser.get());
+        volatile std::size_t size = oss.str().size();
+        (void)size;
+    }));
+    report("buffer", timeIt(1, [&]() {
+        volatile std::size_t size = parser.get().toString().size();
+        (void)size;
+    }));
+    for (std::size_t threads : {2, 4, 8}) {
+        report(std::format("buffer, {} threads", threads), timeIt(1, [&]() {
+            volatile std::size_t size =
+              parser.get().toString({.threads = threads}).size();
+            (void)size;
+        }));
+    }
+}
+
+void benchWriter(std::size_t count) {
+    std::cout << std::format(
+      "\033[1;32m>>> write {} records\033[0m\n", count);
+    report("tree + toString", timeIt(1, [&]() {
+        TJsonObj::ListType records;
+        for (std::size_t i = 0; i < count; ++i) {
+            TJsonObj::DictType record;
+            record["id"]    = static_cast< std::int64_t >(i);
+            record["name"]  = std::format("user{}", i);
+            record["score"] = i % 100 + 0.5;
+            records.emplace_back(std::move(record));
+        }
+        volatile std::size_t size = TJsonObj{records}.toString().size();
+        (void)size;
+    }));
+    std::FILE* null = std::fopen("/dev/null", "wb");
+    report("Writer to /dev/null", timeIt(1, [&]() {
+        Writer writer{FileSink{null}};
+        writer.startList();
+        for (std::size_t i = 0; i < count; ++i) {
+            writer.startObject();
+            writer.key("id");
+            writer.value(i);
+            writer.key("name");
+            writer.value(std::format("user{}", i));
+            writer.key("score");
+            writer.value(i % 100 + 0.5);
+            writer.endObject();
+        }
+        writer.endList();
+    }));
+    std::fclose(null);
+}
+
+// the DictType before the insertion-ordered one, kept for comparison
+using HashDict = std::pmr::unordered_map< TJsonObj::StringType, TJsonObj,
+  __detail::_StringHash, std::equal_to<> >;
+
+template < typename Dict >
+void benchDictOf(std::string_view name, std::size_t keys) {
+    constexpr std::size_t objects = 10000;
+    std::vector< TJsonObj::StringType > names;
+    for (std::size_t k = 0; k < keys; ++k) {
+        names.emplace_back(std::format("field_{}", k));
+    }
+    std::vector< Dict > dicts(objects);
+    report(std::format("{} insert", name), timeIt(1, [&]() {
+        for (auto& dict : dicts) {
+            for (std::size_t k = 0; k < keys; ++k) {
+                dict.try_emplace(names[k], static_cast< int >(k));
+            }
+        }
+    }));
+    std::size_t sum = 0;
+    report(std::format("{} find", name), timeIt(1, [&]() {
+        for (const auto& dict : dicts) {
+            for (const auto& key : names) {
+                sum += dict.find(key)->second.template getNumber< int >();
+            }
+        }
+    }));
+    report(std::format("{} iterate", name), timeIt(1, [&]() {
+        for (const auto& dict : dicts) {
+            for (const auto& [key, value] : dict) {
+                sum += key.size() + value.template getNumber< int >();
+            }
+        }
+    }));
+    volatile std::size_t res = sum;
+    (void)res;
+}
+
+void benchDict() {
+    for (std::size_t keys : {5, 10, 20, 100}) {
+        std::cout << std::format(
+          "\033[1;32m>>> 10000 objects of {} keys\033[0m\n", keys);
+        benchDictOf< HashDict >("unordered_map", keys);
+        benchDictOf< TJsonObj::DictType >("DictType", keys);
+    }
+}
+
+// count the bytes held from the default resource
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    std::size_t bytes = 0;
+
+  private:
+    void* do_allocate(std::size_t size, std::size_t align) override {
+        bytes += size;
+        return std::pmr::new_delete_resource()->allocate(size, align);
+    }
+
+    void do_deallocate(
+      void* ptr, std::size_t size, std::size_t align) override {
+        bytes -= size;
+        std::pmr::new_delete_resource()->deallocate(ptr, size, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+void footprint(std::string_view name, const std::string& json_str) {
+    std::cout << std::format("\033[1;32m>>> memory of {} ({} MB)\033[0m\n",
+      name, json_str.size() >> 20);
+    CountingResource counter;
+    report("TJsonObj tree parse", timeIt(1, [&]() {
+        Parser parser(json_str, ParseOptions{.resource = &counter});
+        std::cout << std::format("{:<32}{:>12.1f} MB\n", "TJsonObj tree",
+          counter.bytes / 1048576.0);
+    }));
+    report("TJsonTape parse", timeIt(1, [&]() {
+        TJsonTape tape(json_str, ParseOptions{.resource = &counter});
+        std::cout << std::format("{:<32}{:>12.1f} MB  {} nodes\n",
+          "TJsonTape", counter.bytes / 1048576.0, tape.nodeCount());
+    }));
+    report("TJsonTape + intern_keys parse", timeIt(1, [&]() {
+        TJsonTape tape(json_str,
+          ParseOptions{.resource = &counter, .intern_keys = true});
+        std::cout << std::format("{:<32}{:>12.1f} MB\n",
+          "TJsonTape + intern_keys", counter.bytes / 1048576.0);
+    }));
+}
+
+// find "nested" then "x" in every record
+void benchKeyLookup(const std::string& records) {
+    std::cout << "\033[1;32m>>> look up keys of every record\033[0m\n";
+    TJsonTape plain(records);
+    TJsonTape interned(records, ParseOptions{.intern_keys = true});
+    std::int64_t sum = 0;
+    report("tape, by chars", timeIt(1, [&]() {
+        for (TapeValue record : plain.root()["records"].items()) {
+            sum += record["nested"]["x"].getNumber< std::int64_t >();
+        }
+    }));
+    report("tape, interned TapeKey", timeIt(1, [&]() {
+        TapeKey nested = interned.key("nested");
+        TapeKey x      = interned.key("x");
+        for (TapeValue record : interned.root()["records"].items()) {
+            sum += record[nested][x].getNumber< std::int64_t >();
+        }
+    }));
+    TJsonObj tree     = Parser(records).get();
+    TJsonObj& list    = tree["records"];
+    std::size_t count = std::get< TJsonObj::ListType >(list.get()).size();
+    report("tree, by string_view", timeIt(1, [&]() {
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += list[i]["nested"]["x"].getNumber< std::int64_t >();
+        }
+    }));
+    report("tree, HashedKey", timeIt(1, [&]() {
+        HashedKey nested{"nested"};
+        HashedKey x{"x"};
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += list[i][nested][x].getNumber< std::int64_t >();
+        }
+    }));
+    volatile std::int64_t res = sum;
+    (void)res;
+}
+
+void benchFootprint(const std::string& records) {
+    std::cout << std::format("sizeof(TJsonObj) {}, sizeof(TapeNode) {}\n",
+      sizeof(TJsonObj), sizeof(TapeNode));
+    std::string numbers = "[";
+    for (std::size_t i = 0; numbers.size() < records.size(); ++i) {
+        numbers.append(i % 2 ? std::format("{}, ", i * 7)
+                             : std::format("{}.{}, ", i, i % 97));
+    }
+    numbers.append("0]");
+    footprint("a list of numbers", numbers);
+    footprint("nested records", records);
+}
+
+void benchFindIndex(const std::string& records) {
+    constexpr std::size_t times = 1000;
+    std::cout << std::format(
+      "\033[1;32m>>> {} lookups on {} MB\033[0m\n", times,
+      records.size() >> 20);
+    TJson tj(records);
+    const TJson& plain = tj;
+    TJson indexed      = tj;
+    indexed.useIndex();
+    const TJson& fast = indexed;
+    std::size_t count =
+      std::get< TJsonObj::ListType >(plain.find("records").get()).size();
+    const std::string last = std::format("/records/{}/nested/x", count - 1);
+
+    report("BFS find", timeIt(times, [&]() { plain.find("nested"); }));
+    report("build the index", timeIt(1, [&]() { fast.find("nested"); }));
+    report("indexed find", timeIt(times, [&]() { fast.find("nested"); }));
+    report("indexed find, non-const",
+      timeIt(times, [&]() { indexed.find("nested"); }));
+    report("at, walk the pointer", timeIt(times, [&]() { plain.at(last); }));
+    report("at, indexed", timeIt(times, [&]() { fast.at(last); }));
+}
+
+// the same paths in every record, like the lines of ndjson
+void benchPointer(const std::string& records) {
+    std::cout << "\033[1;32m>>> 4 paths in every record\033[0m\n";
+    Parser parser(records);
+    const auto& items = std::get< TJsonObj::ListType >(
+      parser.get().at("/records").get());
+    const std::string_view paths[] = {"/id", "/name", "/nested/x", "/tags/2"};
+    std::size_t found              = 0;
+    report("at(string), parsed each time", timeIt(1, [&]() {
+        for (const auto& record : items) {
+            for (auto path : paths) {
+                found += !record.at(path).isString();
+            }
+        }
+    }));
+    report("JsonPointer, parsed once", timeIt(1, [&]() {
+        std::vector< JsonPointer > compiled;
+        for (auto path : paths) {
+            compiled.emplace_back(path);
+        }
+        for (const auto& record : items) {
+            for (const auto& pointer : compiled) {
+                found += !pointer.at(record).isString();
+            }
+        }
+    }));
+    volatile std::size_t res = found;
+    (void)res;
+}
+
+// the records of makeRecords as structs
+struct BenchNested {
+    std::int64_t x = 0;
+    std::optional< std::int64_t > y;
+};
+TJSON_FIELDS(BenchNested, x, y)
+
+struct BenchRecord {
+    std::int64_t id = 0;
+    std::string name;
+    double score = 0;
+    std::vector< std::string > tags;
+    bool ok = false;
+    BenchNested nested;
+};
+TJSON_FIELDS(BenchRecord, id, name, score, tags, ok, nested)
+
+struct BenchRecords {
+    std::vector< BenchRecord > records;
+};
+TJSON_FIELDS(BenchRecords, records)
+
+void benchBind(const std::string& records) {
+    std::cout << std::format(
+      "\033[1;32m>>> structs of {} MB\033[0m\n", records.size() >> 20);
+    BenchRecords walked;
+    report("tree, then std::get", timeIt(1, [&]() {
+        Parser parser(records);
+        const auto& items = std::get< TJsonObj::ListType >(
+          parser.get().at("/records").get());
+        walked.records.clear();
+        for (const auto& item : items) {
+            const auto& dict = std::get< TJsonObj::DictType >(item.get());
+            auto& rec        = walked.records.emplace_back();
+            rec.id    = dict.find("id")->second.getNumber< std::int64_t >();
+            rec.name  = dict.find("name")->second.getString();
+            rec.score = dict.find("score")->second.getNumber< double >();
+            for (const auto& tag : std::get< TJsonObj::ListType >(
+                   dict.find("tags")->second.get()))
+            {
+                rec.tags.emplace_back(tag.getString());
+            }
+            rec.ok = std::get< bool >(dict.find("ok")->second.get());
+            const auto& nested =
+              std::get< TJsonObj::DictType >(dict.find("nested")->second.get());
+            rec.nested.x = nested.find("x")->second.getNumber< std::int64_t >();
+        }
+    }));
+    BenchRecords direct;
+    report("fromJson", timeIt(1, [&]() { fromJson(records, direct); }));
+    report("tree of the structs, toString", timeIt(1, [&]() {
+        TJsonObj::ListType items;
+        for (const auto& rec : direct.records) {
+            TJsonObj item = TJsonObj::DictType{};
+            item.try_emplace("id", rec.id);
+            item.try_emplace("name", rec.name);
+            item.try_emplace("score", rec.score);
+            TJsonObj::ListType tags;
+            for (const auto& tag : rec.tags) {
+                tags.emplace_back(tag);
+            }
+            item.try_emplace("tags", std::move(tags));
+            item.try_emplace("ok", rec.ok);
+            TJsonObj nested = TJsonObj::DictType{};
+            nested.try_emplace("x", rec.nested.x);
+            nested.try_emplace("y");
+            item.try_emplace("nested", std::move(nested));
+            items.push_back(std::move(item));
+        }
+        TJsonObj root = TJsonObj::DictType{};
+        root.try_emplace("records", std::move(items));
+        volatile std::size_t size = root.toString().size();
+        (void)size;
+    }));
+    report("toJson", timeIt(1, [&]() {
+        volatile std::size_t size = toJson(direct).size();
+        (void)size;
+    }));
+    std::cout << std::format("{:<32}{:>12}\n", "",
+      walked.records.size() == direct.records.size()
+          && toJson(walked) == toJson(direct)
+        ? "same"
+        : "differ");
+}
+
+// a few values of a large document, the rest is never parsed
+void benchLazy(const std::string& records) {
+    std::cout << std::format(
+      "\033[1;32m>>> 3 values of {} MB\033[0m\n", records.size() >> 20);
+    std::size_t found = 0;
+    std::size_t count = 0;
+    report("parse the tree", timeIt(1, [&]() {
+        Parser parser(records);
+        const auto& items = std::get< TJsonObj::ListType >(
+          parser.get().at("/records").get());
+        count = items.size();
+        found += items[count / 2].at("/name").isString();
+        found += items[count - 1].at("/nested/x").getNumber< std::size_t >();
+        found += std::get< bool >(items[0].at("/ok").get());
+    }));
+    report("tape", timeIt(1, [&]() {
+        TJsonTape tape(records);
+        TapeValue items = tape.root()["records"];
+        found += items[count / 2]["name"].isString();
+        found += items[count - 1]["nested"]["x"].getNumber< std::size_t >();
+        found += items[0]["ok"].isBool();
+    }));
+    report("lazy, only the structure", timeIt(1, [&]() {
+        LazyDocument doc(records);
+        found += doc.tokenCount();
+    }));
+    report("lazy, 3 values", timeIt(1, [&]() {
+        LazyDocument doc(records);
+        LazyValue items = doc["records"];
+        found += items[count / 2]["name"].getString().size();
+        found += items[count - 1]["nested"]["x"].getNumber< std::size_t >();
+        found += items[0]["ok"].getBool();
+    }));
+    volatile std::size_t res = found;
+    (void)res;
+}
+
+auto main(int argc, char* argv[]) -> signed {
+    // the size of the generated document in MB
+    std::size_t size_mb = argc > 1 ? std::stoul(argv[1]) : 100;
+    try {
+        benchNumber();
+        benchString();
+        benchDict();
+
+        const std::string records = makeRecords(size_mb);
+        benchArena(records);
+        benchConstruct(records);
+        benchFootprint(records);
+        benchKeyLookup(records);
+        benchPointer(records);
+        benchLazy(records);
+        benchBind(records);
+        benchFindIndex(makeRecords(std::max< std::size_t >(size_mb / 10, 1)));
+        benchStructuralIndex(records);
+        benchParallel(records);
+        benchSax(records);
+        benchStream(records);
+        benchNdjson(size_mb);
+        benchFile(records);
+        benchSerialize(records);
+        benchWriter(1000000);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << '\n';
+    }
+}
@@ -11,15 +11,29 @@
 #ifndef __TJSON_HPP__
 #define __TJSON_HPP__
 
-#include <deque>
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <ostream>
+#include <stdexcept>
 #include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 
+#include "tjson/detail/_PathIndex.hpp"
+#include "tjson/tjsonBind.hpp"
 #include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonLazy.hpp"
+#include "tjson/tjsonOptions.hpp"
 #include "tjson/tjsonParser.hpp"
+#include "tjson/tjsonPointer.hpp"
+#include "tjson/tjsonSax.hpp"
+#include "tjson/tjsonStream.hpp"
+#include "tjson/tjsonTape.hpp"
+#include "tjson/tjsonWriter.hpp"
 
 namespace lap {
 
@@ -27,115 +41,251 @@ namespace tjson {
 
 class TJson {
     friend std::ostream& operator<<(std::ostream& os, const TJson& obj) {
-        obj.print();
-        return os;
+        return os << obj.toString(FormatOptions{.indent = 4});
     }
 
+  private:
+    // the arena of the tree if it was parsed with ParseOptions::arena,
+    // declared before the dict so that it is destroyed after it: the dict
+    // is still destroyed node by node, the arena only saves their frees
+    std::unique_ptr< std::pmr::monotonic_buffer_resource > m_arena;
+
   protected:
     TJsonObj::DictType m_json_dict;
 
-  public:
-    TJson()  = default;
-    ~TJson() = default;
+  private:
+    // the index of find and at, built by the first lookup once useIndex
+    // is set and dropped when the tree is replaced
+    struct _IndexSlot {
+        static constexpr std::size_t kNoneLent = std::size_t(-1);
+
+        bool enabled = false;
+        std::unique_ptr< __detail::_PathIndex > index;
+        // the least level of a value given out by a non-const lookup, it
+        // may be changed through the reference at any time, so the index
+        // is not trusted below it
+        std::size_t lent = kNoneLent;
+        std::mutex mutex;
+
+        _IndexSlot() = default;
+
+        // a copy has its own nodes, its index is built again
+        _IndexSlot(const _IndexSlot& other) : enabled{other.enabled} {}
+
+        _IndexSlot& operator=(const _IndexSlot& other) {
+            enabled = other.enabled;
+            index.reset();
+            lent = kNoneLent;
+            return *this;
+        }
+
+        // the moved dict keeps its nodes and the references to them
+        _IndexSlot(_IndexSlot&& other) noexcept
+            : enabled{other.enabled}, index{std::move(other.index)},
+              lent{other.lent} {}
+
+        _IndexSlot& operator=(_IndexSlot&& other) noexcept {
+            enabled = other.enabled;
+            index   = std::move(other.index);
+            lent    = other.lent;
+            return *this;
+        }
+    };
+
+    mutable _IndexSlot m_index;
+
+    // nullptr if useIndex is not set, built under the lock by the first
+    // lookup so that const lookups may run on many threads
+    const __detail::_PathIndex* index() const {
+        if (!m_index.enabled) {
+            return nullptr;
+        }
+        std::lock_guard lock{m_index.mutex};
+        if (!m_index.index) {
+            m_index.index =
+              std::make_unique< __detail::_PathIndex >(m_json_dict);
+        }
+        return m_index.index.get();
+    }
+
+    // BFS, the first value of key by level, then in the order of the
+    // members and elements, with the level it is found at
+    const TJsonObj* search(std::string_view key, std::size_t& level) const {
+        if (m_index.index) {
+            // a key set below a lent value is only found by the walk
+            auto* entry = m_index.index->findKey(key);
+            if (entry && entry->level <= m_index.lent) {
+                level = entry->level;
+                return entry->value;
+            }
+            if (!entry && m_index.lent == _IndexSlot::kNoneLent) {
+                return nullptr;
+            }
+        }
+        const TJsonObj* result = nullptr;
+        __detail::_PathIndex::walk(m_json_dict, false,
+          [&](bool is_key, std::string_view name, const TJsonObj& value,
+            const std::string&, std::size_t depth) {
+              if (is_key && name == key) {
+                  result = &value;
+                  level  = depth;
+              }
+              return result != nullptr;
+          });
+        return result;
+    }
+
+    // the value at a JSON Pointer, nullptr if there is none. The values
+    // up to the lent level are where the index has them.
+    const TJsonObj* resolve(const JsonPointer& pointer) const {
+        if (m_index.index && pointer.size() <= m_index.lent) {
+            auto* entry = m_index.index->findPath(pointer.str());
+            return entry ? entry->value : nullptr;
+        }
+        return pointer.resolveMember(m_json_dict);
+    }
+
+    // a value at level given out to be changed, the index keeps the
+    // values above it
+    TJsonObj& lend(const TJsonObj* value, std::size_t level) {
+        m_index.lent = std::min(m_index.lent, level);
+        return *const_cast< TJsonObj* >(value);
+    }
+
+    [[noreturn]] static void notFound(const JsonPointer& pointer) {
+        throw std::runtime_error(
+          std::format("\033[1;31m{} is not found\033[0m", pointer.str()));
+    }
 
     /***
-     * @brief: will process and get the json to a unordered_map
-     * @param: json_str {string_view}: your json string
+     * @description: make dict the tree, its nodes are not copied. The dict
+     * is built again in place since its resource may differ, the old one
+     * is destroyed first, while its arena is still here.
+     * @param  arena {*}: where dict is allocated, nullptr if not in one
      ***/
-    explicit TJson(const std::string& json_str) {
-        Parser parser(json_str);
-        for (const auto& [key, value] : parser.m_json_obj.toMap().first) {
-            m_json_dict[key] = value;
+    void adopt(TJsonObj::DictType&& dict,
+      std::unique_ptr< std::pmr::monotonic_buffer_resource >&& arena) noexcept {
+        m_index.index.reset();
+        m_index.lent = _IndexSlot::kNoneLent;
+        std::destroy_at(&m_json_dict);
+        std::construct_at(&m_json_dict, std::move(dict));
+        m_arena = std::move(arena);
+    }
+
+    // move the root of parser in, with the arena it is allocated from
+    void take(Parser& parser) {
+        auto* root =
+          std::get_if< TJsonObj::DictType >(&parser.m_json_obj.get());
+        if (!root) {
+            throw std::runtime_error(
+              "\033[1;31mNot a DictType, maybe { or } is missing\033[0m");
         }
+        adopt(std::move(*root), std::move(parser.m_arena));
     }
 
-    void setJsonStr(std::string json_str) {
-        Parser parser(std::move(json_str));
-        for (const auto& [key, value] : parser.m_json_obj.toMap().first) {
-            m_json_dict[key] = value;
+  public:
+    TJson() = default;
+
+    // a copy goes to the default resource, like TJsonObj
+    TJson(const TJson& other)
+        : m_json_dict(other.m_json_dict), m_index{other.m_index} {}
+
+    TJson(TJson&& other) noexcept
+        : m_arena{std::move(other.m_arena)},
+          m_json_dict(std::move(other.m_json_dict)),
+          m_index{std::move(other.m_index)} {
+        other.adopt(TJsonObj::DictType{}, nullptr);
+    }
+
+    TJson& operator=(const TJson& other) {
+        if (this != &other) {
+            adopt(TJsonObj::DictType(other.m_json_dict), nullptr);
+            m_index = other.m_index;
+        }
+        return *this;
+    }
+
+    TJson& operator=(TJson&& other) noexcept {
+        if (this != &other) {
+            adopt(std::move(other.m_json_dict), std::move(other.m_arena));
+            m_index = std::move(other.m_index);
+            other.adopt(TJsonObj::DictType{}, nullptr);
         }
+        return *this;
+    }
+
+    /***
+     * @brief: parse the json string, the root object becomes this TJson
+     * without being copied, with ParseOptions::arena the arena is kept here
+     * @param: json_str {string_view}: your json string
+     * @param: options {ParseOptions}: how to parse the json string
+     * @exception: std::invalid_argument if it can't be parsed,
+     * std::runtime_error if the root is not an object
+     ***/
+    explicit TJson(const std::string& json_str, ParseOptions options = {}) {
+        Parser parser(json_str, options);
+        take(parser);
+    }
+
+    // replace the tree with the one of json_str
+    void setJsonStr(std::string json_str, ParseOptions options = {}) {
+        Parser parser(std::move(json_str), options);
+        take(parser);
+    }
+
+    /**
+     * @brief: replace the tree with the one of the caller's buffer, which
+     * is not copied, with ParseOptions::insitu the strings borrow from it,
+     * so it must outlive this TJson
+     */
+    void setJsonView(std::string_view json_str, ParseOptions options = {}) {
+        Parser parser;
+        parser.setOptions(options);
+        parser.setView(json_str);
+        take(parser);
+    }
+
+    /**
+     * @brief: keep an index of every key and JSON Pointer, so that find
+     * and at are hash lookups. It is built by the first lookup and dropped
+     * by setJsonStr, setJsonView and clear. A non-const lookup gives a
+     * reference that may change the tree, so from then on the values
+     * deeper than it are looked up by a walk again.
+     */
+    void useIndex(bool enabled = true) {
+        m_index.enabled = enabled;
+        m_index.index.reset();
     }
 
     /**
-     * @brief: BFS like search to find the key in json object
+     * @brief: BFS to find the key in json object, level by level, the
+     * members of an object in their order
      * @param: key {string_view}: the key's value you want to find
-     * @return: the reference of the value
+     * @return: the reference of the first value of key
+     * @exception: std::runtime_error if the key is not found
      */
-    TJsonObj& find(const std::string_view key) {
+    const TJsonObj& find(const std::string_view key) const {
         if (m_json_dict.empty()) {
             throw std::runtime_error("json object is empty");
         }
-        const TJsonObj* result{};
-        using std::holds_alternative;
-
-        auto bfs_search = [&]() {
-            // BFS
-            for (auto iter = m_json_dict.begin(); iter != m_json_dict.end();
-              ++iter)
-            {
-                if (iter->first == key) {
-                    return &iter->second;
-                }
-            }
-
-            std::deque< const TJsonObj* > bfs_queue;
-            bfs_queue.push_back(&m_json_dict.begin()->second);
-
-            auto nested = [&](const TJsonObj::DictType& nest_obj) {
-                auto iter = nest_obj.find(key.data());
-                if (iter != nest_obj.end()) {
-                    result = &(iter->second);
-                    return true; // find
-                }
-                return false;
-            };
-
-            auto listed = [&](const TJsonObj::ListType& list_obj) {
-                for (auto element = list_obj.begin(); element != list_obj.end();
-                  ++element)
-                {
-                    if (holds_alternative< TJsonObj::DictType >( // only nest
-                                                                 // to find
-                          element->get()))
-                    {
-                        auto& nest_obj =
-                          std::get< TJsonObj::DictType >(element->get());
-                        if (nested(nest_obj)) {
-                            return true;
-                        }
-                    }
-                }
-                return false;
-            };
-
-            while (!bfs_queue.empty()) {
-                auto bfs_front = bfs_queue.front();
-                bfs_queue.pop_front();
-                if (holds_alternative< TJsonObj::DictType >(bfs_front->get())) {
-                    auto& nesting_obj =
-                      std::get< TJsonObj::DictType >(bfs_front->get());
-                    if (nested(nesting_obj)) {
-                        break;
-                    }
-                }
-                else if (holds_alternative< TJsonObj::ListType >(
-                           bfs_front->get()))
-                {
-                    auto& list_obj =
-                      std::get< TJsonObj::ListType >(bfs_front->get());
-                    if (listed(list_obj)) {
-                        break;
-                    }
-                }
-            }
-
-            if (!result) {
-                throw std::runtime_error("key not found");
-            }
-            return const_cast< TJsonObj* >(result);
-        }();
+        index();
+        std::size_t level = 0;
+        if (const TJsonObj* result = search(key, level)) {
+            return *result;
+        }
+        throw std::runtime_error("key not found");
+    }
 
-        return *const_cast< TJsonObj* >(bfs_search);
+    TJsonObj& find(const std::string_view key) {
+        if (m_json_dict.empty()) {
+            throw std::runtime_error("json object is empty");
+        }
+        index();
+        std::size_t level = 0;
+        if (const TJsonObj* result = search(key, level)) {
+            return lend(result, level);
+        }
+        throw std::runtime_error("key not found");
     }
 
     /**
@@ -145,35 +295,64 @@ class TJson {
      */
     auto& operator[](const std::string_view key) { return find(key); }
 
+    auto& operator[](const std::string_view key) const { return find(key); }
+
+    /**
+     * @brief: the value at a JSON Pointer, like "/list/5/lop", parse it
+     * once with JsonPointer to look it up in many documents
+     * @exception: std::invalid_argument if pointer does not start with /,
+     * std::runtime_error if there is no value at it, "" included since a
+     * TJson is its members
+     */
+    const TJsonObj& at(const JsonPointer& pointer) const {
+        index();
+        if (const TJsonObj* result = resolve(pointer)) {
+            return *result;
+        }
+        notFound(pointer);
+    }
+
+    TJsonObj& at(const JsonPointer& pointer) {
+        index();
+        if (const TJsonObj* result = resolve(pointer)) {
+            return lend(result, pointer.size());
+        }
+        notFound(pointer);
+    }
+
+    const TJsonObj& at(std::string_view pointer) const {
+        return at(JsonPointer{pointer});
+    }
+
+    TJsonObj& at(std::string_view pointer) { return at(JsonPointer{pointer}); }
+
     /**
      * @brief: reset to be empty,
      * you can use setJsonStr to set new json string
      */
-    void clear() { m_json_dict.clear(); }
+    void clear() { adopt(TJsonObj::DictType{}, nullptr); }
 
-    void print() const {
-        std::cout << "\n{";
-        for (const auto& [key, value] : m_json_dict) {
-            std::cout << "\n\t\"" << key << "\": ";
-            value.println();
-        }
-        std::cout << "}";
+    /**
+     * @brief: the json text is built in one buffer and written to
+     * std::cout at once
+     * @param options {FormatOptions}: indented by 4 spaces by default
+     */
+    void print(const FormatOptions& options = {.indent = 4}) const {
+        std::string out = toString(options);
+        std::cout.write(out.data(), out.size());
     }
 
-    void println() const {
-        this->print();
-        std::cout << std::endl;
+    void println(const FormatOptions& options = {.indent = 4}) const {
+        std::string out = toString(options);
+        out.push_back('\n');
+        std::cout.write(out.data(), out.size()).flush();
     }
 
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << "{";
-        for (const auto& [key, value] : m_json_dict) {
-            oss << "\"" << key << "\": ";
-            oss << value.toString() << ",";
-        }
-        oss << "}";
-        return oss.str();
+    // the json text in one buffer, see TJsonObj::toString
+    std::string toString(const FormatOptions& options = {}) const {
+        std::string res;
+        __detail::_ParallelDump::writeObject(res, m_json_dict, options);
+        return res;
     }
 
     auto cbegin() const { return m_json_dict.cbegin(); }
@@ -0,0 +1,140 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-22T10:31:09
+ * @lastmod: 2024-07-22T10:31:09
+ * @description: build the TJsonObj tree from the sax events
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_DomHandler.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_DOM_HANDLER_HPP__
+#define __TJSON_DOM_HANDLER_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tjson/tjsonObj.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+class _DomHandler {
+  private:
+    // a list or an object not closed yet, key is the one of the next value,
+    // it is copied into the object's resource when inserted
+    struct _Frame {
+        std::variant< TJsonObj::ListType, TJsonObj::DictType > container;
+        TJsonObj::StringType key;
+    };
+
+    std::pmr::memory_resource* m_resource;
+    // strings inside it are borrowed if m_insitu is set
+    std::string_view m_source;
+    bool m_insitu;
+
+    std::vector< _Frame > m_stack;
+    TJsonObj m_root;
+
+    void add(TJsonObj&& value) {
+        if (m_stack.empty()) {
+            m_root = std::move(value);
+            return;
+        }
+        auto& frame = m_stack.back();
+        if (auto* list = std::get_if< TJsonObj::ListType >(&frame.container)) {
+            list->emplace_back(std::move(value));
+        }
+        else {
+            // the last one wins if a key is repeated
+            std::get< TJsonObj::DictType >(frame.container)
+              .insert_or_assign(std::move(frame.key), std::move(value));
+        }
+    }
+
+    template < typename Container >
+    void endContainer() {
+        TJsonObj value{std::in_place_type< Container >,
+          std::move(std::get< Container >(m_stack.back().container))};
+        m_stack.pop_back();
+        add(std::move(value));
+    }
+
+  public:
+    _DomHandler(std::pmr::memory_resource* resource,
+      std::string_view source = {}, bool insitu = false)
+        : m_resource{resource}, m_source{source}, m_insitu{insitu} {}
+
+    void onStartObject() {
+        m_stack.emplace_back().container.emplace< TJsonObj::DictType >(
+          m_resource);
+    }
+
+    void onKey(std::string_view key) { m_stack.back().key.assign(key); }
+
+    void onEndObject() { endContainer< TJsonObj::DictType >(); }
+
+    void onStartList() {
+        m_stack.emplace_back().container.emplace< TJsonObj::ListType >(
+          m_resource);
+    }
+
+    void onEndList() { endContainer< TJsonObj::ListType >(); }
+
+    void onString(std::string_view str) {
+        // a decoded string is not inside the source
+        if (m_insitu && str.data() >= m_source.data()
+            && str.data() < m_source.data() + m_source.size())
+        {
+            add(TJsonObj{std::in_place_type< std::string_view >, str});
+        }
+        else {
+            add(TJsonObj{
+              std::in_place_type< TJsonObj::StringType >, str, m_resource});
+        }
+    }
+
+    // stored as int if it fits, like the numbers written by hand
+    void onInt64(std::int64_t value) {
+        if (value >= std::numeric_limits< int >::min()
+            && value <= std::numeric_limits< int >::max())
+        {
+            add(TJsonObj{static_cast< int >(value)});
+        }
+        else {
+            add(TJsonObj{value});
+        }
+    }
+
+    void onUint64(std::uint64_t value) { add(TJsonObj{value}); }
+
+    void onDouble(double value) { add(TJsonObj{value}); }
+
+    void onRawNumber(std::string_view str) {
+        add(TJsonObj{std::in_place_type< RawNumber >,
+          RawNumber{TJsonObj::StringType{str, m_resource}}});
+    }
+
+    void onBool(bool value) { add(TJsonObj{value}); }
+
+    void onNull() { add(TJsonObj{std::monostate{}}); }
+
+    // the tree built so far, the handler is empty after it
+    TJsonObj take() { return std::move(m_root); }
+};
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_DOM_HANDLER_HPP__
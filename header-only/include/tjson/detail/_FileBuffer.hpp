@@ -0,0 +1,177 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-25T10:48:02
+ * @lastmod: 2024-07-25T10:48:02
+ * @description: the whole content of a file, mapped if the system can
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_FileBuffer.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_FILE_BUFFER_HPP__
+#define __TJSON_FILE_BUFFER_HPP__
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define __TJSON_MMAP__ 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+/***
+ * @description: read only bytes of a file, a regular file is mapped with
+ * mmap and read by the parser in place, anything else (a pipe, a system
+ * without mmap, or a failed mmap) is read into one buffer sized up front
+ ***/
+class _FileBuffer {
+  private:
+    // the mapping, or nullptr if the bytes are in m_copy
+    const char* m_map = nullptr;
+    std::size_t m_size = 0;
+    std::string m_copy;
+
+    void release() noexcept {
+#ifdef __TJSON_MMAP__
+        if (m_map) {
+            ::munmap(const_cast< char* >(m_map), m_size);
+        }
+#endif
+        m_map  = nullptr;
+        m_size = 0;
+        m_copy.clear();
+    }
+
+#ifdef __TJSON_MMAP__
+    // read() until the end, the buffer is sized from st_size if known, and
+    // only grows once a small read behind it still gets data
+    void readAll(int fd, std::size_t size_hint) {
+        m_copy.resize(size_hint ? size_hint : 1 << 16);
+        std::size_t size = 0;
+        char probe[4096];
+        while (true) {
+            bool full     = size == m_copy.size();
+            ssize_t count = full ? ::read(fd, probe, sizeof(probe))
+                                 : ::read(fd, m_copy.data() + size,
+                                     m_copy.size() - size);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(
+                  "\033[1;31mfailed to read the file\033[0m");
+            }
+            if (count == 0) {
+                break;
+            }
+            if (full) {
+                // append grows the capacity geometrically, use all of it
+                m_copy.append(probe, count);
+                size += count;
+                m_copy.resize(m_copy.capacity());
+                continue;
+            }
+            size += count;
+        }
+        m_copy.resize(size);
+    }
+#endif
+
+  public:
+    _FileBuffer() = default;
+
+    explicit _FileBuffer(const std::filesystem::path& path) {
+#ifdef __TJSON_MMAP__
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("\033[1;31mfile not found\033[0m");
+        }
+        struct stat st{};
+        bool regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        if (regular && st.st_size > 0) {
+            void* map =
+              ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                // the parser reads the bytes once from the front
+                ::madvise(map, st.st_size, MADV_SEQUENTIAL);
+                m_map  = static_cast< const char* >(map);
+                m_size = st.st_size;
+            }
+        }
+        try {
+            if (!m_map) {
+                readAll(fd, regular ? st.st_size : 0);
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        // the mapping stays valid without the fd
+        ::close(fd);
+#else
+        std::ifstream ifs(path, std::ios::in | std::ios::binary);
+        if (!ifs.is_open()) {
+            throw std::runtime_error("\033[1;31mfile not found\033[0m");
+        }
+        m_copy.assign(std::istreambuf_iterator< char >(ifs),
+          std::istreambuf_iterator< char >());
+#endif
+    }
+
+    ~_FileBuffer() { release(); }
+
+    // a copy is never mapped
+    _FileBuffer(const _FileBuffer& other) : m_copy{other.view()} {}
+
+    _FileBuffer& operator=(const _FileBuffer& other) {
+        if (this != &other) {
+            std::string copy{other.view()};
+            release();
+            m_copy = std::move(copy);
+        }
+        return *this;
+    }
+
+    _FileBuffer(_FileBuffer&& other) noexcept { *this = std::move(other); }
+
+    _FileBuffer& operator=(_FileBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            m_map  = std::exchange(other.m_map, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_copy = std::move(other.m_copy);
+        }
+        return *this;
+    }
+
+    std::string_view view() const noexcept {
+        return m_map ? std::string_view{m_map, m_size} : m_copy;
+    }
+
+    bool isMapped() const noexcept { return m_map != nullptr; }
+};
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_FILE_BUFFER_HPP__
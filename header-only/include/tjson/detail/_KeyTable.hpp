@@ -0,0 +1,130 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-30T14:26:51
+ * @lastmod: 2024-07-30T14:26:51
+ * @description: a set of object keys, each text stored once
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_KeyTable.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_KEY_TABLE_HPP__
+#define __TJSON_KEY_TABLE_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+/***
+ * @description: the keys are appended to a buffer of chars owned by the
+ * caller, the table only keeps their offset, size and hash. The same text
+ * always gets the same offset, so two interned keys are equal if their
+ * offsets are.
+ ***/
+class _KeyTable {
+  public:
+    static constexpr std::uint64_t npos = static_cast< std::uint64_t >(-1);
+
+  private:
+    struct _Slot {
+        std::uint64_t offset = npos; // npos is an empty slot
+        std::uint32_t size   = 0;
+        std::uint32_t hash   = 0;
+    };
+
+    std::pmr::vector< _Slot > m_slots;
+    std::size_t m_count = 0;
+
+    static std::uint32_t hashOf(std::string_view key) noexcept {
+        return static_cast< std::uint32_t >(
+          std::hash< std::string_view >{}(key));
+    }
+
+    // the slot of key, or the empty one it goes to
+    std::size_t probe(std::string_view key, std::uint32_t hash,
+      std::string_view chars) const noexcept {
+        std::size_t mask = m_slots.size() - 1;
+        std::size_t i    = hash & mask;
+        while (m_slots[i].offset != npos) {
+            const _Slot& slot = m_slots[i];
+            if (slot.hash == hash && slot.size == key.size()
+                && chars.substr(slot.offset, slot.size) == key)
+            {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // at most half of the slots are used
+    void grow() {
+        std::pmr::vector< _Slot > slots(
+          m_slots.empty() ? 64 : m_slots.size() * 2, m_slots.get_allocator());
+        std::size_t mask = slots.size() - 1;
+        for (const _Slot& slot : m_slots) {
+            if (slot.offset != npos) {
+                std::size_t i = slot.hash & mask;
+                while (slots[i].offset != npos) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = slot;
+            }
+        }
+        m_slots = std::move(slots);
+    }
+
+  public:
+    explicit _KeyTable(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_slots(resource) {}
+
+    // the offset of key in chars, it is appended the first time
+    std::uint64_t intern(std::string_view key, std::pmr::string& chars) {
+        if ((m_count + 1) * 2 > m_slots.size()) {
+            grow();
+        }
+        std::uint32_t hash = hashOf(key);
+        _Slot& slot        = m_slots[probe(key, hash, chars)];
+        if (slot.offset == npos) {
+            slot = _Slot{chars.size(), static_cast< std::uint32_t >(key.size()),
+              hash};
+            chars.append(key);
+            ++m_count;
+        }
+        return slot.offset;
+    }
+
+    // the offset of key, npos if it was never interned
+    std::uint64_t find(std::string_view key, std::string_view chars) const {
+        if (m_slots.empty()) {
+            return npos;
+        }
+        return m_slots[probe(key, hashOf(key), chars)].offset;
+    }
+
+    // how many different keys
+    std::size_t size() const noexcept { return m_count; }
+
+    std::size_t memoryBytes() const noexcept {
+        return m_slots.capacity() * sizeof(_Slot);
+    }
+};
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_KEY_TABLE_HPP__
@@ -0,0 +1,427 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-28T09:12:40
+ * @lastmod: 2024-07-28T09:12:40
+ * @description: the storage of a json object, a flat vector of the members
+ * in the order they are inserted
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_OrderedDict.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_ORDERED_DICT_HPP__
+#define __TJSON_ORDERED_DICT_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+/***
+ * @description: the members are kept in one vector in insertion order, so
+ * a small object is a single allocation that is walked front to back. A
+ * small object is searched linearly, once it has more than kLinearMax
+ * members an open addressing index of the positions is built in the same
+ * memory resource and kept up to date. Iterators are the vector's, so an
+ * insert or erase invalidates them, and a key must not be changed through
+ * an iterator.
+ ***/
+template < typename Value >
+class _OrderedDict {
+  public:
+    using key_type       = std::pmr::string;
+    using mapped_type    = Value;
+    using value_type     = std::pair< key_type, Value >;
+    using size_type      = std::size_t;
+    using allocator_type = std::pmr::polymorphic_allocator< value_type >;
+    using iterator       = typename std::pmr::vector< value_type >::iterator;
+    using const_iterator =
+      typename std::pmr::vector< value_type >::const_iterator;
+
+    // up to this many members are searched without the index
+    static constexpr std::size_t kLinearMax = 8;
+
+  private:
+    static constexpr std::size_t npos = static_cast< std::size_t >(-1);
+
+    std::pmr::vector< value_type > m_items;
+    // a slot is the high half of the hash and the position + 1, 0 is empty
+    std::uint64_t* m_slots     = nullptr;
+    std::uint32_t m_slot_count = 0;
+
+    static std::size_t hashOf(std::string_view key) noexcept {
+        return std::hash< std::string_view >{}(key);
+    }
+
+    static std::uint64_t tagOf(std::size_t hash) noexcept {
+        return static_cast< std::uint64_t >(hash) & 0xffffffff00000000ull;
+    }
+
+    std::pmr::memory_resource* resource() const noexcept {
+        return m_items.get_allocator().resource();
+    }
+
+    void freeSlots() noexcept {
+        if (m_slots) {
+            resource()->deallocate(m_slots,
+              m_slot_count * sizeof(std::uint64_t), alignof(std::uint64_t));
+        }
+        m_slots      = nullptr;
+        m_slot_count = 0;
+    }
+
+    void allocSlots(std::uint32_t count) {
+        m_slots = static_cast< std::uint64_t* >(resource()->allocate(
+          count * sizeof(std::uint64_t), alignof(std::uint64_t)));
+        m_slot_count = count;
+    }
+
+    void place(std::size_t hash, std::size_t pos) noexcept {
+        std::size_t mask = m_slot_count - 1;
+        std::size_t i    = hash & mask;
+        while (m_slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        m_slots[i] = tagOf(hash) | (pos + 1);
+    }
+
+    // (re)build the index for every member, at most half of it is used
+    void buildIndex() {
+        std::uint32_t count = 32;
+        while (count < m_items.size() * 2) {
+            count *= 2;
+        }
+        freeSlots();
+        allocSlots(count);
+        std::memset(m_slots, 0, count * sizeof(std::uint64_t));
+        for (std::size_t pos = 0; pos < m_items.size(); ++pos) {
+            place(hashOf(m_items[pos].first), pos);
+        }
+    }
+
+    // the same index as other's, the positions are the same
+    void copySlots(const _OrderedDict& other) {
+        freeSlots();
+        if (other.m_slots) {
+            allocSlots(other.m_slot_count);
+            std::memcpy(m_slots, other.m_slots,
+              m_slot_count * sizeof(std::uint64_t));
+        }
+    }
+
+    void stealSlots(_OrderedDict& other) noexcept {
+        freeSlots();
+        m_slots      = std::exchange(other.m_slots, nullptr);
+        m_slot_count = std::exchange(other.m_slot_count, 0);
+    }
+
+    // the position of key, and its hash if the index is used
+    std::pair< std::size_t, std::size_t > locate(
+      std::string_view key) const noexcept {
+        if (!m_slots) {
+            for (std::size_t pos = 0; pos < m_items.size(); ++pos) {
+                const key_type& item = m_items[pos].first;
+                if (item.size() == key.size() && item == key) {
+                    return {pos, 0};
+                }
+            }
+            return {npos, 0};
+        }
+        return locate(key, hashOf(key));
+    }
+
+    // hash is std::hash< std::string_view > of key
+    std::pair< std::size_t, std::size_t > locate(
+      std::string_view key, std::size_t hash) const noexcept {
+        if (!m_slots) {
+            return {locate(key).first, hash};
+        }
+        std::uint64_t tag = tagOf(hash);
+        std::size_t mask  = m_slot_count - 1;
+        for (std::size_t i = hash & mask; m_slots[i] != 0; i = (i + 1) & mask)
+        {
+            std::uint64_t slot = m_slots[i];
+            if ((slot & 0xffffffff00000000ull) == tag) {
+                std::size_t pos = (slot & 0xffffffffull) - 1;
+                if (m_items[pos].first == key) {
+                    return {pos, hash};
+                }
+            }
+        }
+        return {npos, hash};
+    }
+
+    // skip the growth through 1 and 2 members
+    void reserveFirst() {
+        if (m_items.capacity() == 0) {
+            m_items.reserve(4);
+        }
+    }
+
+    // index the member just pushed back
+    void indexBack(std::size_t hash) {
+        if (m_slots) {
+            if (m_items.size() * 2 > m_slot_count) {
+                buildIndex();
+            }
+            else {
+                place(hash, m_items.size() - 1);
+            }
+        }
+        else if (m_items.size() > kLinearMax) {
+            buildIndex();
+        }
+    }
+
+    template < typename K, typename... Args >
+    std::pair< iterator, bool > emplaceNew(K&& key, Args&&... args) {
+        auto [pos, hash] = locate(std::string_view{key});
+        if (pos != npos) {
+            return {m_items.begin() + pos, false};
+        }
+        reserveFirst();
+        m_items.emplace_back(std::piecewise_construct,
+          std::forward_as_tuple(std::forward< K >(key)),
+          std::forward_as_tuple(std::forward< Args >(args)...));
+        indexBack(hash);
+        return {m_items.end() - 1, true};
+    }
+
+  public:
+    _OrderedDict() = default;
+
+    explicit _OrderedDict(const allocator_type& alloc) : m_items(alloc) {}
+
+    explicit _OrderedDict(std::pmr::memory_resource* resource)
+        : m_items(resource) {}
+
+    _OrderedDict(std::initializer_list< value_type > init,
+      const allocator_type& alloc = {})
+        : m_items(alloc) {
+        m_items.reserve(init.size());
+        for (const auto& item : init) {
+            insert_or_assign(item.first, item.second);
+        }
+    }
+
+    // a copy goes to the default resource, like the pmr containers
+    _OrderedDict(const _OrderedDict& other) : m_items(other.m_items) {
+        copySlots(other);
+    }
+
+    _OrderedDict(const _OrderedDict& other, const allocator_type& alloc)
+        : m_items(other.m_items, alloc) {
+        copySlots(other);
+    }
+
+    _OrderedDict(_OrderedDict&& other) noexcept
+        : m_items(std::move(other.m_items)) {
+        stealSlots(other);
+    }
+
+    _OrderedDict(_OrderedDict&& other, const allocator_type& alloc)
+        : m_items(std::move(other.m_items), alloc) {
+        if (resource() == other.resource()) {
+            stealSlots(other);
+        }
+        else {
+            copySlots(other);
+            other.clear();
+        }
+    }
+
+    _OrderedDict& operator=(const _OrderedDict& other) {
+        if (this != &other) {
+            m_items = other.m_items;
+            copySlots(other);
+        }
+        return *this;
+    }
+
+    // the resource is kept, the members are moved one by one if it differs
+    _OrderedDict& operator=(_OrderedDict&& other) noexcept {
+        if (this != &other) {
+            m_items = std::move(other.m_items);
+            if (resource() == other.resource()) {
+                stealSlots(other);
+            }
+            else {
+                copySlots(other);
+                other.clear();
+            }
+        }
+        return *this;
+    }
+
+    ~_OrderedDict() { freeSlots(); }
+
+    allocator_type get_allocator() const noexcept {
+        return m_items.get_allocator();
+    }
+
+    iterator begin() noexcept { return m_items.begin(); }
+
+    iterator end() noexcept { return m_items.end(); }
+
+    const_iterator begin() const noexcept { return m_items.begin(); }
+
+    const_iterator end() const noexcept { return m_items.end(); }
+
+    const_iterator cbegin() const noexcept { return m_items.cbegin(); }
+
+    const_iterator cend() const noexcept { return m_items.cend(); }
+
+    bool empty() const noexcept { return m_items.empty(); }
+
+    std::size_t size() const noexcept { return m_items.size(); }
+
+    void reserve(std::size_t count) { m_items.reserve(count); }
+
+    void clear() noexcept {
+        m_items.clear();
+        freeSlots();
+    }
+
+    iterator find(std::string_view key) {
+        std::size_t pos = locate(key).first;
+        return pos == npos ? m_items.end() : m_items.begin() + pos;
+    }
+
+    const_iterator find(std::string_view key) const {
+        std::size_t pos = locate(key).first;
+        return pos == npos ? m_items.end() : m_items.begin() + pos;
+    }
+
+    // the hash of key is given, std::hash< std::string_view > of it
+    iterator find(std::string_view key, std::size_t hash) {
+        std::size_t pos = locate(key, hash).first;
+        return pos == npos ? m_items.end() : m_items.begin() + pos;
+    }
+
+    const_iterator find(std::string_view key, std::size_t hash) const {
+        std::size_t pos = locate(key, hash).first;
+        return pos == npos ? m_items.end() : m_items.begin() + pos;
+    }
+
+    bool contains(std::string_view key) const {
+        return locate(key).first != npos;
+    }
+
+    std::size_t count(std::string_view key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    Value& at(std::string_view key) {
+        if (auto iter = find(key); iter != end()) {
+            return iter->second;
+        }
+        throw std::out_of_range("\033[1;31mthe key is not found\033[0m");
+    }
+
+    const Value& at(std::string_view key) const {
+        if (auto iter = find(key); iter != end()) {
+            return iter->second;
+        }
+        throw std::out_of_range("\033[1;31mthe key is not found\033[0m");
+    }
+
+    // a new member is appended, the key is copied into the resource
+    template < typename K >
+        requires std::is_convertible_v< const K&, std::string_view >
+    Value& operator[](K&& key) {
+        return emplaceNew(std::forward< K >(key)).first->second;
+    }
+
+    // nothing is constructed if the key is there
+    template < typename K, typename... Args >
+        requires std::is_convertible_v< const K&, std::string_view >
+    std::pair< iterator, bool > try_emplace(K&& key, Args&&... args) {
+        return emplaceNew(
+          std::forward< K >(key), std::forward< Args >(args)...);
+    }
+
+    // a repeated key keeps its place and takes the new value
+    template < typename K, typename M >
+        requires std::is_convertible_v< const K&, std::string_view >
+    std::pair< iterator, bool > insert_or_assign(K&& key, M&& value) {
+        auto [pos, hash] = locate(std::string_view{key});
+        if (pos != npos) {
+            m_items[pos].second = std::forward< M >(value);
+            return {m_items.begin() + pos, false};
+        }
+        reserveFirst();
+        m_items.emplace_back(std::forward< K >(key), std::forward< M >(value));
+        indexBack(hash);
+        return {m_items.end() - 1, true};
+    }
+
+    template < typename K, typename M >
+        requires std::is_convertible_v< const K&, std::string_view >
+    std::pair< iterator, bool > emplace(K&& key, M&& value) {
+        return emplaceNew(std::forward< K >(key), std::forward< M >(value));
+    }
+
+    std::pair< iterator, bool > insert(const value_type& item) {
+        return emplaceNew(item.first, item.second);
+    }
+
+    std::pair< iterator, bool > insert(value_type&& item) {
+        return emplaceNew(std::move(item.first), std::move(item.second));
+    }
+
+    // the members behind it move one place to the front
+    iterator erase(const_iterator pos) {
+        auto iter = m_items.erase(pos);
+        if (m_items.size() > kLinearMax) {
+            buildIndex();
+        }
+        else {
+            freeSlots();
+        }
+        return iter;
+    }
+
+    std::size_t erase(std::string_view key) {
+        std::size_t pos = locate(key).first;
+        if (pos == npos) {
+            return 0;
+        }
+        erase(m_items.cbegin() + pos);
+        return 1;
+    }
+
+    // equal members in any order, like two json objects
+    bool operator==(const _OrderedDict& other) const {
+        if (size() != other.size()) {
+            return false;
+        }
+        for (const auto& [key, value] : m_items) {
+            auto iter = other.find(key);
+            if (iter == other.end() || !(iter->second == value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_ORDERED_DICT_HPP__
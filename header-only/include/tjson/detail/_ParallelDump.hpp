@@ -0,0 +1,287 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-08-04T10:26:35
+ * @lastmod: 2024-08-04T10:26:35
+ * @description: write the parts of a large tree on many threads and join
+ * the text in order
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_ParallelDump.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_PARALLEL_DUMP_HPP__
+#define __TJSON_PARALLEL_DUMP_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "tjson/detail/_Serializer.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+namespace _ParallelDump {
+
+// a smaller tree is not worth the threads
+inline constexpr std::size_t kMinValues = 1 << 16;
+
+// how many levels of small lists and objects to look under for a large one
+inline constexpr std::size_t kMaxDescend = 4;
+
+// the values in obj, only counted up to limit
+template < typename Obj >
+std::size_t countValues(const Obj& obj, std::size_t limit) {
+    std::size_t count = 1;
+    auto add          = [&](const Obj& value) {
+        if (count < limit) {
+            count += countValues(value, limit - count);
+        }
+    };
+    if (auto* list = std::get_if< typename Obj::ListType >(&obj.get())) {
+        std::for_each(list->begin(), list->end(), add);
+    }
+    else if (auto* dict = std::get_if< typename Obj::DictType >(&obj.get())) {
+        for (const auto& item : *dict) {
+            add(item.second);
+        }
+    }
+    return count;
+}
+
+/***
+ * @description: the text of a tree as pieces in order. A list or object of
+ * many elements is cut into ranges of elements, each a task that writes
+ * its own piece. The brackets, keys and , around them, and any value too
+ * deep to look into, are written into the pieces between the tasks at once.
+ ***/
+template < typename Obj >
+class _Planner {
+  private:
+    using Dict   = typename Obj::DictType;
+    using Member = typename Dict::value_type;
+
+    struct _Task {
+        std::size_t piece;
+        std::function< void(std::string&) > write;
+    };
+
+    const FormatOptions& m_options;
+    std::size_t m_threads;
+    std::vector< std::string > m_pieces{1};
+    std::vector< _Task > m_tasks;
+
+    // the piece written now, between the tasks
+    std::string& text() { return m_pieces.back(); }
+
+    /***
+     * @description: the elements [0, size) between open and close
+     * @param  write {Callable}: write(out, i) writes the element i with the
+     * , before it
+     * @param  plan {Callable}: plan(i) does the same by planning it
+     ***/
+    template < typename Write, typename Plan >
+    void planElements(std::size_t size, char open, char close,
+      std::size_t depth, std::size_t descend, Write write, Plan plan) {
+        text().push_back(open);
+        if (size >= m_threads * 2) {
+            std::size_t parts = std::min(m_threads * 4, size);
+            for (std::size_t part = 0; part < parts; ++part) {
+                std::size_t first = size * part / parts;
+                std::size_t last  = size * (part + 1) / parts;
+                m_tasks.push_back(_Task{m_pieces.size(),
+                  [write, first, last](std::string& out) {
+                      for (std::size_t i = first; i < last; ++i) {
+                          write(out, i);
+                      }
+                  }});
+                m_pieces.emplace_back();
+                m_pieces.emplace_back();
+            }
+        }
+        else if (descend < kMaxDescend) {
+            for (std::size_t i = 0; i < size; ++i) {
+                plan(i);
+            }
+        }
+        else {
+            for (std::size_t i = 0; i < size; ++i) {
+                write(text(), i);
+            }
+        }
+        if (m_options.indent > 0 && !m_options.compact) {
+            _Serializer::newLine(text(), m_options, depth);
+        }
+        text().push_back(close);
+    }
+
+  public:
+    _Planner(const FormatOptions& options, std::size_t threads)
+      : m_options{options}, m_threads{threads} {}
+
+    void planObject(const Dict& dict, std::size_t depth, std::size_t descend) {
+        if (dict.empty()) {
+            _Serializer::writeRaw(text(), "{}");
+            return;
+        }
+        // the tasks keep the order of the members
+        auto members = std::make_shared< std::vector< const Member* > >();
+        members->reserve(dict.size());
+        for (const auto& item : dict) {
+            members->push_back(&item);
+        }
+        if (m_options.sort_keys) {
+            std::sort(members->begin(), members->end(),
+              [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+        }
+        const FormatOptions& options = m_options;
+        planElements(
+          members->size(), '{', '}', depth, descend,
+          [members, &options, depth](std::string& out, std::size_t i) {
+              _Serializer::beforeElement(out, options, depth, i == 0);
+              _Serializer::writeKey(out, (*members)[i]->first, options);
+              _Serializer::writeValue(
+                out, (*members)[i]->second, options, depth + 1);
+          },
+          [&](std::size_t i) {
+              _Serializer::beforeElement(text(), options, depth, i == 0);
+              _Serializer::writeKey(text(), (*members)[i]->first, options);
+              planValue((*members)[i]->second, depth + 1, descend + 1);
+          });
+    }
+
+    void planValue(const Obj& obj, std::size_t depth, std::size_t descend) {
+        const FormatOptions& options = m_options;
+        if (auto* list = std::get_if< typename Obj::ListType >(&obj.get())) {
+            if (list->empty()) {
+                _Serializer::writeRaw(text(), "[]");
+                return;
+            }
+            planElements(
+              list->size(), '[', ']', depth, descend,
+              [list, &options, depth](std::string& out, std::size_t i) {
+                  _Serializer::beforeElement(out, options, depth, i == 0);
+                  _Serializer::writeValue(out, (*list)[i], options, depth + 1);
+              },
+              [&](std::size_t i) {
+                  _Serializer::beforeElement(text(), options, depth, i == 0);
+                  planValue((*list)[i], depth + 1, descend + 1);
+              });
+        }
+        else if (auto* dict = std::get_if< Dict >(&obj.get())) {
+            planObject(*dict, depth, descend);
+        }
+        else {
+            _Serializer::writeValue(text(), obj, options, depth);
+        }
+    }
+
+    // write the pieces of the tasks, at most one thread for each task
+    void run() {
+        std::vector< std::exception_ptr > errors(m_tasks.size());
+        std::atomic< std::size_t > next{0};
+        auto work = [&]() {
+            for (std::size_t i = next++; i < m_tasks.size(); i = next++) {
+                try {
+                    m_tasks[i].write(m_pieces[m_tasks[i].piece]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+        std::vector< std::thread > workers;
+        for (std::size_t t = 1; t < std::min(m_threads, m_tasks.size()); ++t) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // append the pieces in order, each is freed once it is copied
+    template < _Serializer::CharSink Sink >
+    void flush(Sink& sink) {
+        if constexpr (requires { sink.reserve(sink.size()); }) {
+            std::size_t total = sink.size();
+            for (const auto& piece : m_pieces) {
+                total += piece.size();
+            }
+            sink.reserve(total);
+        }
+        for (auto& piece : m_pieces) {
+            sink.append(piece.data(), piece.size());
+            std::string{}.swap(piece);
+        }
+    }
+};
+
+inline std::size_t threadCount(const FormatOptions& options) {
+    return options.threads ? options.threads
+                           : std::thread::hardware_concurrency();
+}
+
+/***
+ * @description: like _Serializer::writeValue, with options.threads the
+ * parts of a tree of at least kMinValues values are written at once
+ * @param  obj {Obj}: a TJsonObj, a template so that this header does not
+ * need it
+ ***/
+template < _Serializer::CharSink Sink, typename Obj >
+void writeValue(Sink& sink, const Obj& obj, const FormatOptions& options) {
+    std::size_t threads = threadCount(options);
+    if (threads < 2 || countValues(obj, kMinValues) < kMinValues) {
+        _Serializer::writeValue(sink, obj, options);
+        return;
+    }
+    _Planner< Obj > planner{options, threads};
+    planner.planValue(obj, 0, 0);
+    planner.run();
+    planner.flush(sink);
+}
+
+// the same for the members of a DictType, TJson uses it for its own map
+template < _Serializer::CharSink Sink, typename Dict >
+void writeObject(Sink& sink, const Dict& dict, const FormatOptions& options) {
+    using Obj           = typename Dict::mapped_type;
+    std::size_t threads = threadCount(options);
+    std::size_t count   = 1;
+    for (auto iter = dict.begin(); iter != dict.end() && count < kMinValues;
+      ++iter)
+    {
+        count += countValues(iter->second, kMinValues - count);
+    }
+    if (threads < 2 || count < kMinValues) {
+        _Serializer::writeObject(sink, dict, options);
+        return;
+    }
+    _Planner< Obj > planner{options, threads};
+    planner.planObject(dict, 0, 0);
+    planner.run();
+    planner.flush(sink);
+}
+
+} // namespace _ParallelDump
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_PARALLEL_DUMP_HPP__
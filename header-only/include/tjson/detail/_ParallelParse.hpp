@@ -0,0 +1,254 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-08-03T09:48:12
+ * @lastmod: 2024-08-03T09:48:12
+ * @description: parse the elements of a large root list or object on many
+ * threads and join them in order
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_ParallelParse.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_PARALLEL_PARSE_HPP__
+#define __TJSON_PARALLEL_PARSE_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "_DomHandler.hpp"
+#include "_ParserScan.hpp"
+#include "_SimdScan.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+namespace _ParallelParse {
+
+// a part smaller than this is not worth a thread
+inline constexpr std::size_t kMinPartBytes = 1 << 20;
+
+// the root list or object and the , where it is cut into parts
+struct _RootSplit {
+    std::size_t begin; // the { or [
+    std::size_t end;   // its } or ]
+    std::vector< std::size_t > cuts;
+};
+
+/***
+ * @description: stage 1 again, but only the depth is followed, a block
+ * with no chance to close the root or hold a cut is counted with two
+ * popcounts. A cut is the first , of the root behind each part_bytes.
+ * @return: nullopt if the root is not a list or object or is not closed
+ * by its own ] or }, the serial parser then tells what is wrong
+ ***/
+inline std::optional< _RootSplit > splitRoot(
+  const std::string_view json_str, std::size_t part_bytes) {
+    std::size_t begin = _ParserScan::jumpWhiteSpace(json_str, 0);
+    if (begin >= json_str.size()
+        || (json_str[begin] != '[' && json_str[begin] != '{'))
+    {
+        return std::nullopt;
+    }
+
+    _RootSplit split{begin, 0, {}};
+    auto classify = _SimdScan::bestClassify();
+    _SimdScan::_StringTracker strings;
+    std::size_t depth  = 0;
+    std::size_t target = begin + part_bytes;
+    for (std::size_t base = begin & ~std::size_t{63};
+      base < json_str.size(); base += 64)
+    {
+        auto masks     = _SimdScan::classifyAt(json_str, base, classify);
+        auto in_string = strings.next(masks).second;
+        // the chars before the root are white space
+        std::uint64_t outside =
+          ~in_string & (base < begin ? ~std::uint64_t{0} << (begin - base)
+                                     : ~std::uint64_t{0});
+        std::uint64_t open  = masks.open & outside;
+        std::uint64_t close = masks.close & outside;
+        auto closes = static_cast< std::size_t >(std::popcount(close));
+        if (base + 64 <= target && closes < depth) {
+            depth += std::popcount(open);
+            depth -= closes;
+            continue;
+        }
+        for (std::uint64_t ops = masks.op & outside; ops; ops &= ops - 1) {
+            std::size_t pos = base + std::countr_zero(ops);
+            if (open >> (pos - base) & 1) {
+                ++depth;
+            }
+            else if (close >> (pos - base) & 1) {
+                if (--depth == 0) {
+                    char open_char = json_str[begin];
+                    if (json_str[pos] != (open_char == '[' ? ']' : '}')) {
+                        return std::nullopt;
+                    }
+                    split.end = pos;
+                    return split;
+                }
+            }
+            else if (depth == 1 && pos >= target && json_str[pos] == ',') {
+                split.cuts.push_back(pos);
+                target = pos + part_bytes;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/***
+ * @description: the elements or members of the root in [begin, end), the
+ * , before and behind them are not included, as a list or dict of their
+ * own
+ * @exception: std::invalid_argument with the position in the whole json
+ * string
+ ***/
+inline TJsonObj parsePart(const std::string_view json_str, bool is_dict,
+  std::size_t begin, std::size_t end, const ParseOptions& options) {
+    using namespace _ParserScan;
+    _ScanContext ctx{options};
+    _DomHandler dom{ctx.opts.resource, json_str, ctx.opts.insitu};
+    is_dict ? dom.onStartObject() : dom.onStartList();
+
+    std::size_t reads = begin;
+    _TJsonToken::Type state{};
+    while (true) {
+        update_state(json_str, state, reads, ctx);
+        if (is_dict) {
+            scanMember(json_str, state, reads, ctx, dom);
+        }
+        else {
+            scanValue(json_str, state, reads, ctx, dom);
+        }
+        update_state(json_str, state, reads, ctx);
+        if (reads == end) {
+            break;
+        }
+        if (reads > end || state != _TJsonToken::VALUE_SEPRATOR) {
+            throw std::invalid_argument(
+              std::format("\033[1;31mexpect , or {} at {}\033[0m",
+                is_dict ? "}" : "]", reads));
+        }
+        ++reads; // skip ,
+    }
+
+    is_dict ? dom.onEndObject() : dom.onEndList();
+    return dom.take();
+}
+
+/***
+ * @description: cut a root list or object at its , and parse the parts on
+ * threads, the elements are moved into one list or dict in order. A
+ * repeated key of the root takes the last value, as in one thread.
+ * @param  options {ParseOptions}: resource must be set and safe to use
+ * from many threads, structural_index is not used
+ * @return: nullopt if the json string is too small for two parts or its
+ * root is not a list or object, parse it on one thread then
+ * @exception: std::invalid_argument from the first part that fails
+ ***/
+inline std::optional< TJsonObj > parseRoot(const std::string_view json_str,
+  const ParseOptions& options, std::size_t threads) {
+    std::size_t parts =
+      std::min(threads * 4, json_str.size() / kMinPartBytes);
+    if (threads < 2 || parts < 2) {
+        return std::nullopt;
+    }
+    auto split = splitRoot(json_str, json_str.size() / parts);
+    if (!split || split->cuts.empty()) {
+        return std::nullopt;
+    }
+    // only white space behind the root
+    std::size_t rest = _ParserScan::jumpWhiteSpace(json_str, split->end + 1);
+    if (rest < json_str.size()) {
+        throw std::invalid_argument(
+          std::format("\033[1;31munexpected character {} at {}\033[0m",
+            json_str.substr(rest, 1), rest));
+    }
+
+    const bool is_dict = json_str[split->begin] == '{';
+    std::vector< std::size_t > bounds{split->begin};
+    bounds.insert(bounds.end(), split->cuts.begin(), split->cuts.end());
+    bounds.push_back(split->end);
+    const std::size_t count = bounds.size() - 1;
+
+    std::vector< TJsonObj > results(count);
+    std::vector< std::exception_ptr > errors(count);
+    std::atomic< std::size_t > next{0};
+    auto work = [&]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            try {
+                results[i] = parsePart(
+                  json_str, is_dict, bounds[i] + 1, bounds[i + 1], options);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector< std::thread > workers;
+    for (std::size_t t = 1; t < std::min(threads, count); ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    if (is_dict) {
+        TJsonObj::DictType dict(options.resource);
+        std::size_t total = 0;
+        for (auto& part : results) {
+            total += std::get< TJsonObj::DictType >(part.get()).size();
+        }
+        dict.reserve(total);
+        for (auto& part : results) {
+            for (auto& [key, value] :
+              std::get< TJsonObj::DictType >(part.get()))
+            {
+                dict.insert_or_assign(std::move(key), std::move(value));
+            }
+        }
+        return TJsonObj{std::move(dict)};
+    }
+    TJsonObj::ListType list(options.resource);
+    std::size_t total = 0;
+    for (auto& part : results) {
+        total += std::get< TJsonObj::ListType >(part.get()).size();
+    }
+    list.reserve(total);
+    for (auto& part : results) {
+        for (auto& value : std::get< TJsonObj::ListType >(part.get())) {
+            list.push_back(std::move(value));
+        }
+    }
+    return TJsonObj{std::move(list)};
+}
+
+} // namespace _ParallelParse
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_PARALLEL_PARSE_HPP__
@@ -12,10 +12,17 @@
 #define __TJSON_DETAIL_HPP__
 
 #include <charconv>
-#include <regex>
-
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "_SimdScan.hpp"
 #include "_TJsonToken.hpp"
-#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
 
 namespace lap {
 
@@ -25,7 +32,7 @@ namespace __detail {
 
 namespace _ParserScan {
 
-bool isNumberBegin(char ch) {
+inline bool isNumberBegin(char ch) {
     // number can't begin with '+'
     if (ch == '+')
         throw std::invalid_argument(
@@ -33,23 +40,23 @@ bool isNumberBegin(char ch) {
     return (ch >= '0' && ch <= '9') || ch == '-';
 }
 
-bool isStringBegin(char ch) { return ch == '\"'; }
+inline bool isStringBegin(char ch) { return ch == '\"'; }
 
-bool isListBegin(char ch) { return ch == '['; }
+inline bool isListBegin(char ch) { return ch == '['; }
 
-bool isJsonNestingBegin(char ch) { return ch == '{'; }
+inline bool isJsonNestingBegin(char ch) { return ch == '{'; }
 
-bool isBooleanTrue(char ch) { return ch == 't'; }
+inline bool isBooleanTrue(char ch) { return ch == 't'; }
 
-bool isBooleanFalse(char ch) { return ch == 'f'; }
+inline bool isBooleanFalse(char ch) { return ch == 'f'; }
 
-bool isLiteralNull(char ch) { return ch == 'n'; }
+inline bool isLiteralNull(char ch) { return ch == 'n'; }
 
-bool isWhiteSpace(char ch) {
+inline bool isWhiteSpace(char ch) {
     return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
 }
 
-char escapeChar(char ch) {
+inline char escapeChar(char ch) {
     switch (ch) {
         case 'n':
             return '\n';
@@ -72,7 +79,7 @@ char escapeChar(char ch) {
     }
 }
 
-char unescapeChar(char ch) {
+inline char unescapeChar(char ch) {
     switch (ch) {
         case '\n':
             return 'n';
@@ -95,7 +102,7 @@ char unescapeChar(char ch) {
     }
 }
 
-_TJsonToken::Type scanChar(char json_begin = ' ') {
+inline _TJsonToken::Type scanChar(char json_begin = ' ') {
     /***
      * @description: scan the json string begin
      * and return the token type
@@ -145,27 +152,120 @@ _TJsonToken::Type scanChar(char json_begin = ' ') {
     }
 }
 
-std::string escapeString(const std::string& str) {
-    /***
-     * @description: make the string with escape char
-     ***/
-    std::string res;
-    for (size_t i = 0; i < str.size(); ++i) {
-        if (str[i] == '\\') {
-            if (i + 1 < str.size()) {
-                res.push_back(escapeChar(str[i + 1]));
-                ++i;
-            }
+// the value of a hex digit, -1 if not one
+inline int hexValue(char ch) noexcept {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+// append the code point as utf-8
+template < typename String >
+void appendUtf8(String& res, char32_t code) {
+    if (code < 0x80) {
+        res.push_back(static_cast< char >(code));
+    }
+    else if (code < 0x800) {
+        res.push_back(static_cast< char >(0xC0 | (code >> 6)));
+        res.push_back(static_cast< char >(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000) {
+        res.push_back(static_cast< char >(0xE0 | (code >> 12)));
+        res.push_back(static_cast< char >(0x80 | ((code >> 6) & 0x3F)));
+        res.push_back(static_cast< char >(0x80 | (code & 0x3F)));
+    }
+    else {
+        res.push_back(static_cast< char >(0xF0 | (code >> 18)));
+        res.push_back(static_cast< char >(0x80 | ((code >> 12) & 0x3F)));
+        res.push_back(static_cast< char >(0x80 | ((code >> 6) & 0x3F)));
+        res.push_back(static_cast< char >(0x80 | (code & 0x3F)));
+    }
+}
+
+/***
+ * @description: decode the escape chars in a json string body to utf-8,
+ * \" \\ \/ \b \f \n \r \t and \uXXXX with surrogate pairs
+ * @param res {String}: the decoded chars are appended to it
+ * @param offset {std::size_t}: where the body is in the json string, only
+ * used to report the error position
+ * @exception: std::invalid_argument if an escape is not valid json
+ ***/
+template < typename String >
+void escapeString(
+  const std::string_view str, String& res, std::size_t offset = 0) {
+    res.reserve(res.size() + str.size());
+
+    auto invalid = [&](std::size_t pos, std::string_view what) {
+        return std::invalid_argument(std::format(
+          "\033[1;31minvalid json escape, {} at {}\033[0m", what,
+          offset + pos));
+    };
+    // the 4 hex digits behind \u at pos
+    auto readHex4 = [&](std::size_t pos) -> char32_t {
+        if (pos + 4 > str.size()) throw invalid(pos, "expect 4 hex digits");
+        char32_t code = 0;
+        for (std::size_t i = pos; i < pos + 4; ++i) {
+            int digit = hexValue(str[i]);
+            if (digit < 0) throw invalid(i, "expect a hex digit");
+            code = (code << 4) | static_cast< char32_t >(digit);
         }
-        else {
-            res.push_back(str[i]);
+        return code;
+    };
+
+    std::size_t pos = 0;
+    while (pos < str.size()) {
+        // copy the run before the next escape at once
+        auto slash = str.find('\\', pos);
+        res.append(str.substr(pos, slash - pos));
+        if (slash == std::string_view::npos) {
+            break;
+        }
+        if (slash + 1 >= str.size()) throw invalid(slash, "nothing escaped");
+
+        pos = slash + 2;
+        switch (str[slash + 1]) {
+            case '"':
+            case '\\':
+            case '/':
+                res.push_back(str[slash + 1]);
+                break;
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                res.push_back(escapeChar(str[slash + 1]));
+                break;
+            case 'u': {
+                char32_t code = readHex4(pos);
+                pos += 4;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    // a high surrogate must be followed by a low one
+                    if (str.substr(pos, 2) != "\\u") {
+                        throw invalid(pos, "expect a low surrogate");
+                    }
+                    char32_t low = readHex4(pos + 2);
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        throw invalid(pos, "expect a low surrogate");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                }
+                else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    throw invalid(pos - 6, "lone low surrogate");
+                }
+                appendUtf8(res, code);
+                break;
+            }
+            default:
+                throw invalid(slash, "unknown escape char");
         }
     }
-    return res;
 }
 
 // will make the escape char to normal
-std::string unescapeString(const std::string& str) {
+inline std::string unescapeString(std::string_view str) {
     auto IsEscapeChar = [](char ch) -> bool {
         return (ch == '\n' || ch == '\t' || ch == '\a' || ch == '\b' ||
                 ch == '\t' || ch == '\0' || ch == '\v' || ch == '\f');
@@ -183,7 +283,7 @@ std::string unescapeString(const std::string& str) {
     return res;
 }
 
-std::size_t jumpWhiteSpace(
+inline std::size_t jumpWhiteSpace(
   const std::string_view str, std::size_t begin) noexcept {
     for (; begin < str.size(); ++begin) {
         if (!isWhiteSpace(str[begin])) {
@@ -203,114 +303,380 @@ std::optional< T > tryParse(std::string_view str) noexcept {
     return std::nullopt;
 }
 
-void update_state(std::string& json_str, _TJsonToken::Type& state,
-  std::size_t& reads, std::size_t begin) {
-    reads    = jumpWhiteSpace(json_str, begin);
-    state    = scanChar(json_str[reads]);
-    json_str = json_str.substr(reads);
+// what the scan functions share while parsing one buffer
+struct _ScanContext {
+    ParseOptions opts; // the resource is always set
+
+    // the token positions from stage 1, see ParseOptions::structural_index,
+    // walked instead of the white space when not empty
+    std::vector< std::uint32_t > index;
+    std::size_t index_pos = 0;
+
+    // the strings with escape chars are decoded here, reused for each one
+    std::string scratch;
 };
 
-TJsonObj dealValueString(
-  std::string& json_str, _TJsonToken::Type& state, std::size_t& reads) {
-    // find the end of the json object
-    auto find_res = json_str.find("\"");
-    if (find_res != std::string::npos) {
-        for (std::size_t i = find_res + 1; i < json_str.size(); i++) {
-            if (json_str[i] == '\"') {
-                find_res = i;
+/***
+ * @description: skip the white space and scan the token at the cursor,
+ * the cursor only moves forward and the buffer is never copied
+ ***/
+inline void update_state(const std::string_view json_str,
+  _TJsonToken::Type& state, std::size_t& reads, _ScanContext& ctx) {
+    if (ctx.index.empty()) {
+        reads = jumpWhiteSpace(json_str, reads);
+    }
+    else {
+        // the next token is the next position behind the cursor, the rest
+        // of a number or literal is not in the index, so anything but white
+        // space right behind the cursor is garbage glued to the last token
+        while (ctx.index_pos < ctx.index.size() &&
+               ctx.index[ctx.index_pos] < reads)
+        {
+            ++ctx.index_pos;
+        }
+        std::size_t next = ctx.index_pos < ctx.index.size()
+                           ? ctx.index[ctx.index_pos]
+                           : json_str.size();
+        if (reads < next && !isWhiteSpace(json_str[reads])) {
+            throw std::invalid_argument(std::format(
+              "\033[1;31munexpected character {} at {}\033[0m",
+              json_str.substr(reads, 1), reads));
+        }
+        reads = next;
+    }
+    state = reads < json_str.size() ? scanChar(json_str[reads])
+                                    : _TJsonToken::END;
+};
+
+// the body of a json string, whether it has escape chars to decode, and
+// where it is in the json string
+struct _StringSpan {
+    std::string_view str;
+    bool has_escape;
+    std::size_t offset;
+};
+
+/***
+ * @description: json_str[reads] is the opening ", return the body between
+ * the quotes and move the cursor behind the closing one, an escaped " does
+ * not close the string
+ * @exception: std::invalid_argument if the string is not closed or has a
+ * raw control char
+ ***/
+inline _StringSpan scanString(
+  const std::string_view json_str, std::size_t& reads) {
+    const char* const data = json_str.data();
+    const char* const end  = data + json_str.size();
+    const char* pos        = data + reads + 1;
+    bool has_escape        = false;
+    while (true) {
+        // jump over the plain chars, many bytes at a time
+        pos = _SimdScan::findStringSpecial(pos, end);
+        if (pos == end) {
+            break;
+        }
+        if (*pos == '\"') {
+            std::size_t length = pos - data - reads - 1;
+            _StringSpan res{
+              json_str.substr(reads + 1, length), has_escape, reads + 1};
+            reads = pos - data + 1;
+            return res;
+        }
+        if (*pos == '\\') {
+            has_escape = true;
+            if (end - pos < 2) {
                 break;
             }
+            pos += 2; // the escaped char is checked when decoding
+            continue;
         }
-        // the json object to be implemented
-        std::string res = json_str.substr(1, find_res - 1).data();
-        json_str        = json_str.substr(find_res + 1);
-        return TJsonObj{std::move(res)};
+        throw std::invalid_argument(std::format(
+          "\033[1;31mcontrol char must be escaped in json string at {}\033[0m",
+          pos - data));
     }
-    else {
-        throw std::invalid_argument(
-          "\033[1;31mjson string end with no \"\033[0m");
+    throw std::invalid_argument(
+      "\033[1;31mjson string end with no \"\033[0m");
+}
+
+/***
+ * @description: the handler gets the decoded string, it borrows from the
+ * json string if there is no escape char, else from ctx.scratch, which is
+ * overwritten by the next string
+ ***/
+inline std::string_view decodeString(
+  const _StringSpan& span, _ScanContext& ctx) {
+    if (!span.has_escape) {
+        return span.str;
     }
+    ctx.scratch.clear();
+    escapeString(span.str, ctx.scratch, span.offset);
+    return ctx.scratch;
+}
+
+template < typename Handler >
+void dealValueString(const std::string_view json_str,
+  _TJsonToken::Type& state, std::size_t& reads, _ScanContext& ctx,
+  Handler& handler) {
+    handler.onString(decodeString(scanString(json_str, reads), ctx));
 }
 
-TJsonObj dealValueNumber(std::string& json_str, _TJsonToken::Type& state,
-  std::size_t& reads) { // regex the float number and the scientific notation
-    std::regex number_re{"[-]?[0-9]+(\\.[0-9]*)?([eE][+-]?[0-9]+)?"};
-
-    //  store the match result
-    std::match_results< decltype(json_str.begin()) > sub_match;
-
-    if (std::regex_search(
-          json_str.begin(), json_str.end(), sub_match, number_re))
-    {
-        // if we find the number, then we try to parse it
-        auto str = sub_match.str();
-        if (auto value = tryParse< int >(str); value.has_value()) {
-            json_str = json_str.substr(str.size());
-            return TJsonObj{value.value()};
+inline bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+// the span of a json number and whether it has fraction or exponent
+struct _NumberSpan {
+    std::string_view str;
+    bool is_integer;
+};
+
+/***
+ * @description: scan a json number at the cursor in one forward pass,
+ * -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ * @exception: std::invalid_argument with the position of the bad char
+ ***/
+inline _NumberSpan scanNumber(
+  const std::string_view json_str, std::size_t& reads) {
+    const std::size_t begin = reads;
+    const std::size_t size  = json_str.size();
+    std::size_t pos         = reads;
+    bool is_integer         = true;
+
+    auto expectDigit = [&](const char* what) {
+        if (pos >= size || !isDigit(json_str[pos])) {
+            throw std::invalid_argument(
+              std::format("\033[1;31minvalid json number, expect a digit {} "
+                          "at {}\033[0m",
+                what, pos));
         }
-        if (auto value = tryParse< double >(str); value.has_value()) {
-            json_str = json_str.substr(str.size());
-            return TJsonObj{value.value()};
+    };
+    auto skipDigits = [&]() {
+        while (pos < size && isDigit(json_str[pos])) ++pos;
+    };
+
+    if (json_str[pos] == '-') ++pos;
+    expectDigit("in integer part");
+    if (json_str[pos] == '0') {
+        ++pos; // no leading zero
+    }
+    else {
+        skipDigits();
+    }
+    if (pos < size && json_str[pos] == '.') {
+        ++pos;
+        is_integer = false;
+        expectDigit("after .");
+        skipDigits();
+    }
+    if (pos < size && (json_str[pos] == 'e' || json_str[pos] == 'E')) {
+        ++pos;
+        is_integer = false;
+        if (pos < size && (json_str[pos] == '+' || json_str[pos] == '-')) {
+            ++pos;
         }
+        expectDigit("in exponent");
+        skipDigits();
     }
-    return TJsonObj{};
+    reads = pos;
+    return {json_str.substr(begin, pos - begin), is_integer};
 }
 
-template < typename Callable >
-TJsonObj deaList(std::string& json_str, _TJsonToken::Type& state,
-  std::size_t& reads, Callable&& op) {
-    TJsonObj::ListType res{};
-    reads = 1;
-    while (reads < json_str.size()) {
-        update_state(json_str, state, reads, 1);
-
-        if (json_str[0] == ']' && json_str.size() > 1) {
-            state    = _TJsonToken::LIST_END;
-            json_str = json_str.substr(1);
-            return TJsonObj{std::move(res)};
+// give the number to the handler, begin is only used to report the error
+template < typename Handler >
+void emitNumber(const _NumberSpan& span, std::size_t begin,
+  _ScanContext& ctx, Handler& handler) {
+    auto [str, is_integer] = span;
+    if (ctx.opts.raw_number) {
+        handler.onRawNumber(str);
+        return;
+    }
+    if (is_integer) {
+        // out of range falls through to double
+        if (auto value = tryParse< std::int64_t >(str); value.has_value()) {
+            handler.onInt64(value.value());
+            return;
         }
+        if (auto value = tryParse< std::uint64_t >(str); value.has_value()) {
+            handler.onUint64(value.value());
+            return;
+        }
+    }
+    if (auto value = tryParse< double >(str); value.has_value()) {
+        handler.onDouble(value.value());
+        return;
+    }
+    throw std::invalid_argument(std::format(
+      "\033[1;31minvalid json number {} at {}\033[0m", str, begin));
+}
 
-        auto obj = std::forward< Callable >(op)(json_str, state, reads);
+template < typename Handler >
+void dealValueNumber(const std::string_view json_str,
+  _TJsonToken::Type& state, std::size_t& reads, _ScanContext& ctx,
+  Handler& handler) {
+    const std::size_t begin = reads;
+    emitNumber(scanNumber(json_str, reads), begin, ctx, handler);
+}
 
-        res.push_back(std::move(obj));
+// json_str[reads] begins the literal, true false or null
+inline void expectLiteral(const std::string_view json_str, std::size_t& reads,
+  const std::string_view literal) {
+    if (json_str.substr(reads, literal.size()) != literal) {
+        throw std::invalid_argument(std::format(
+          "\033[1;31mjson literal {} ,maybe you mean {}\033[0m",
+          json_str.substr(reads, literal.size()), literal));
     }
-    return TJsonObj{std::move(res)};
+    reads += literal.size();
 }
 
-template < typename Callable >
-TJsonObj dealObjBegin(std::string& json_str, _TJsonToken::Type& state,
-  std::size_t& reads, Callable&& op) {
-    TJsonObj::DictType res{};
-    reads = 1;
-    while (reads < json_str.size()) {
-        update_state(json_str, state, reads, 1);
-
-        if (json_str[0] == '}' && json_str.size() > 1) {
-            state    = _TJsonToken::END_OBJECT;
-            json_str = json_str.substr(1);
-            return TJsonObj{std::move(res)};
-        }
+template < typename Handler >
+void scanValue(const std::string_view json_str, _TJsonToken::Type& state,
+  std::size_t& reads, _ScanContext& ctx, Handler& handler);
+
+template < typename Handler >
+void deaList(const std::string_view json_str, _TJsonToken::Type& state,
+  std::size_t& reads, _ScanContext& ctx, Handler& handler) {
+    handler.onStartList();
+    ++reads; // skip [
+    update_state(json_str, state, reads, ctx);
+    if (state == _TJsonToken::LIST_END) {
+        ++reads;
+        handler.onEndList();
+        return;
+    }
+
+    while (true) {
+        scanValue(json_str, state, reads, ctx, handler);
 
-        if (json_str[0] == ':') {
-            state    = _TJsonToken::VALUE_SEPRATOR;
-            json_str = json_str.substr(1);
-            return std::forward< Callable >(op)(json_str, state, reads);
+        update_state(json_str, state, reads, ctx);
+        if (state == _TJsonToken::LIST_END) {
+            ++reads;
+            handler.onEndList();
+            return;
+        }
+        if (state != _TJsonToken::VALUE_SEPRATOR) {
+            throw std::invalid_argument(std::format(
+              "\033[1;31mexpect , or ] in list at {}\033[0m", reads));
         }
+        ++reads; // skip ,
+        update_state(json_str, state, reads, ctx);
+    }
+}
 
-        // get the key
-        auto keyobj = std::forward< Callable >(op)(json_str, state, reads);
-
-        if (std::holds_alternative< std::string >(keyobj.get())) {
-            // to get the value,should make sure the map has the
-            // key, then to find the value.
-            res[std::get< std::string >(keyobj.get())] =
-              TJsonObj{std::monostate{}};
-            update_state(json_str, state, reads, 1);
-            auto valobj = std::forward< Callable >(op)(json_str, state, reads);
-            res[std::get< std::string >(keyobj.get())] = std::move(valobj);
+// the key, : and value of one member of an object, the key at the cursor
+template < typename Handler >
+void scanMember(const std::string_view json_str, _TJsonToken::Type& state,
+  std::size_t& reads, _ScanContext& ctx, Handler& handler) {
+    if (state != _TJsonToken::VALUE_STRING) {
+        throw std::invalid_argument(std::format(
+          "\033[1;31mexpect a string key at {}\033[0m", reads));
+    }
+    handler.onKey(decodeString(scanString(json_str, reads), ctx));
+
+    update_state(json_str, state, reads, ctx);
+    if (state != _TJsonToken::NAME_SEPRATOR) {
+        throw std::invalid_argument(
+          std::format("\033[1;31mexpect : at {}\033[0m", reads));
+    }
+    ++reads; // skip :
+    update_state(json_str, state, reads, ctx);
+
+    scanValue(json_str, state, reads, ctx, handler);
+}
+
+template < typename Handler >
+void dealObjBegin(const std::string_view json_str, _TJsonToken::Type& state,
+  std::size_t& reads, _ScanContext& ctx, Handler& handler) {
+    handler.onStartObject();
+    ++reads; // skip {
+    update_state(json_str, state, reads, ctx);
+    if (state == _TJsonToken::END_OBJECT) {
+        ++reads;
+        handler.onEndObject();
+        return;
+    }
+
+    while (true) {
+        scanMember(json_str, state, reads, ctx, handler);
+
+        update_state(json_str, state, reads, ctx);
+        if (state == _TJsonToken::END_OBJECT) {
+            ++reads;
+            handler.onEndObject();
+            return;
         }
+        if (state != _TJsonToken::VALUE_SEPRATOR) {
+            throw std::invalid_argument(std::format(
+              "\033[1;31mexpect , or }} in object at {}\033[0m", reads));
+        }
+        ++reads; // skip ,
+        update_state(json_str, state, reads, ctx);
+    }
+}
+
+/***
+ * @param  json_str {std::string_view}: the whole json buffer, read only
+ * @param  state {_TJsonToken::Type}: use as a state machine
+ * @param  reads {std::size_t}: the cursor, how much you have read
+ * @param  ctx {_ScanContext}: how to parse
+ * @param  handler {Handler}: gets an event for each token, see SaxHandler
+ * @exception: std::invalid_argument if the string can't be parsed
+ * @description: scan the json value at the cursor and move the cursor
+ * behind it
+ ***/
+template < typename Handler >
+void scanValue(const std::string_view json_str, _TJsonToken::Type& state,
+  std::size_t& reads, _ScanContext& ctx, Handler& handler) {
+    switch (state) {
+        case _TJsonToken::BEGIN_OBJECT:
+            return dealObjBegin(json_str, state, reads, ctx, handler);
+        case _TJsonToken::LIST_BEGIN:
+            return deaList(json_str, state, reads, ctx, handler);
+        case _TJsonToken::VALUE_NUMBER:
+            return dealValueNumber(json_str, state, reads, ctx, handler);
+        case _TJsonToken::VALUE_STRING:
+            return dealValueString(json_str, state, reads, ctx, handler);
+        case _TJsonToken::LITERAL_TRUE:
+            expectLiteral(json_str, reads, "true");
+            return handler.onBool(true);
+        case _TJsonToken::LITERAL_FALSE:
+            expectLiteral(json_str, reads, "false");
+            return handler.onBool(false);
+        case _TJsonToken::LITERAL_NULL:
+            expectLiteral(json_str, reads, "null");
+            return handler.onNull();
+        default:
+            break;
+    }
+    throw std::invalid_argument(
+      std::format("\033[1;31munexpected character {} at {}\033[0m",
+        json_str.substr(reads, 1), reads));
+}
+
+/***
+ * @description: scan a whole json string, an empty one gives a null, and
+ * only white space is allowed behind the root
+ ***/
+template < typename Handler >
+void scanDocument(
+  const std::string_view json_str, _ScanContext& ctx, Handler& handler) {
+    // stage 1, the positions fit in 32 bits
+    if (ctx.opts.structural_index && json_str.size() <= UINT32_MAX) {
+        _SimdScan::buildStructuralIndex(json_str, ctx.index);
+    }
+
+    std::size_t reads = 0;
+    _TJsonToken::Type state{};
+    update_state(json_str, state, reads, ctx);
+    if (state == _TJsonToken::END && reads >= json_str.size()) {
+        handler.onNull();
+        return;
+    }
+    scanValue(json_str, state, reads, ctx, handler);
+
+    update_state(json_str, state, reads, ctx);
+    if (reads < json_str.size()) {
+        throw std::invalid_argument(
+          std::format("\033[1;31munexpected character {} at {}\033[0m",
+            json_str.substr(reads, 1), reads));
     }
-    return TJsonObj{std::move(res)};
 }
 
 } // namespace _ParserScan
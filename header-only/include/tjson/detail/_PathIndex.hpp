@@ -0,0 +1,163 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-31T16:40:22
+ * @lastmod: 2024-07-31T16:40:22
+ * @description: the values of a TJson by key name and by JSON Pointer
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_PathIndex.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_PATH_INDEX_HPP__
+#define __TJSON_PATH_INDEX_HPP__
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "tjson/tjsonObj.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+class _PathIndex {
+  public:
+    // a value and its level, 1 for a member of the root
+    struct _Entry {
+        const TJsonObj* value;
+        std::size_t level;
+    };
+
+  private:
+    using _Map =
+      std::unordered_map< std::string, _Entry, _StringHash, std::equal_to<> >;
+
+    // the first value of each key, in the order TJson::find searches
+    _Map m_keys;
+    // every value by its JSON Pointer, "/list/3/name"
+    _Map m_paths;
+
+  public:
+    // ~ and / of a key are written as ~0 and ~1 in a JSON Pointer
+    static void appendToken(std::string& path, std::string_view key) {
+        path.push_back('/');
+        for (char ch : key) {
+            if (ch == '~') {
+                path.append("~0");
+            }
+            else if (ch == '/') {
+                path.append("~1");
+            }
+            else {
+                path.push_back(ch);
+            }
+        }
+    }
+
+    /***
+     * @description: visit the members of root level by level, the members
+     * of an object in their order and the elements of a list by index.
+     * visit(is_key, key, value, path, level) is called for each of them,
+     * key is the index of an element, and it returns true to stop.
+     * @param  with_path {bool}: build the paths, they are empty otherwise
+     ***/
+    template < typename Visit >
+    static void walk(
+      const TJsonObj::DictType& root, bool with_path, Visit&& visit) {
+        std::deque< std::tuple< const TJsonObj*, std::string, std::size_t > >
+          queue;
+        auto member = [&](bool is_key, std::string_view key,
+                        const TJsonObj& value, const std::string& parent,
+                        std::size_t level) {
+            std::string path;
+            if (with_path) {
+                path = parent;
+                if (is_key) {
+                    appendToken(path, key);
+                }
+                else {
+                    path.push_back('/');
+                    path.append(key);
+                }
+            }
+            if (visit(is_key, key, value, path, level)) {
+                return true;
+            }
+            if (std::holds_alternative< TJsonObj::DictType >(value.get())
+                || std::holds_alternative< TJsonObj::ListType >(value.get()))
+            {
+                queue.emplace_back(&value, std::move(path), level);
+            }
+            return false;
+        };
+        auto object = [&](const TJsonObj::DictType& dict,
+                        const std::string& parent, std::size_t level) {
+            for (const auto& [key, value] : dict) {
+                if (member(true, key, value, parent, level)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        if (object(root, std::string{}, 1)) {
+            return;
+        }
+        while (!queue.empty()) {
+            auto [node, path, level] = std::move(queue.front());
+            queue.pop_front();
+            if (auto* dict = std::get_if< TJsonObj::DictType >(&node->get()))
+            {
+                if (object(*dict, path, level + 1)) {
+                    return;
+                }
+                continue;
+            }
+            const auto& list = std::get< TJsonObj::ListType >(node->get());
+            for (std::size_t i = 0; i < list.size(); ++i) {
+                std::string index = with_path ? std::to_string(i) : "";
+                if (member(false, index, list[i], path, level + 1)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    explicit _PathIndex(const TJsonObj::DictType& root) {
+        walk(root, true,
+          [this](bool is_key, std::string_view key, const TJsonObj& value,
+            std::string& path, std::size_t level) {
+              if (is_key) {
+                  m_keys.try_emplace(std::string{key}, _Entry{&value, level});
+              }
+              m_paths.try_emplace(path, _Entry{&value, level});
+              return false;
+          });
+    }
+
+    const _Entry* findKey(std::string_view key) const {
+        auto iter = m_keys.find(key);
+        return iter == m_keys.end() ? nullptr : &iter->second;
+    }
+
+    const _Entry* findPath(std::string_view path) const {
+        auto iter = m_paths.find(path);
+        return iter == m_paths.end() ? nullptr : &iter->second;
+    }
+};
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_PATH_INDEX_HPP__
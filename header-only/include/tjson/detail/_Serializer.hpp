@@ -0,0 +1,424 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-26T15:32:10
+ * @lastmod: 2024-07-26T15:32:10
+ * @description: write a json value into one buffer, no stream in between
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_Serializer.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_SERIALIZER_HPP__
+#define __TJSON_SERIALIZER_HPP__
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "tjson/detail/_SimdScan.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+namespace _Serializer {
+
+// where the json text goes, std::string is one
+template < typename Sink >
+concept CharSink =
+  requires(Sink& sink, const char* str, std::size_t size, char ch) {
+      sink.append(str, size);
+      sink.push_back(ch);
+  };
+
+// write through any output iterator of char
+template < typename Iter >
+class _IteratorSink {
+  private:
+    Iter m_iter;
+
+  public:
+    explicit _IteratorSink(Iter iter) : m_iter{iter} {}
+
+    void append(const char* str, std::size_t size) {
+        m_iter = std::copy_n(str, size, m_iter);
+    }
+
+    void push_back(char ch) { *m_iter++ = ch; }
+
+    Iter base() const { return m_iter; }
+};
+
+template < CharSink Sink >
+void writeRaw(Sink& sink, std::string_view str) {
+    sink.append(str.data(), str.size());
+}
+
+// write the escape of ", \ or a control char
+template < CharSink Sink >
+void writeEscape(Sink& sink, char ch) {
+    static constexpr char hex[] = "0123456789abcdef";
+    switch (ch) {
+        case '\"':
+            writeRaw(sink, "\\\"");
+            break;
+        case '\\':
+            writeRaw(sink, "\\\\");
+            break;
+        case '\b':
+            writeRaw(sink, "\\b");
+            break;
+        case '\f':
+            writeRaw(sink, "\\f");
+            break;
+        case '\n':
+            writeRaw(sink, "\\n");
+            break;
+        case '\r':
+            writeRaw(sink, "\\r");
+            break;
+        case '\t':
+            writeRaw(sink, "\\t");
+            break;
+        default: {
+            const char code[] = {
+              '\\', 'u', '0', '0', hex[(ch >> 4) & 0xF], hex[ch & 0xF]};
+            sink.append(code, sizeof(code));
+            break;
+        }
+    }
+}
+
+/***
+ * @description: write the string quoted, " \ and the control chars are
+ * escaped, the plain runs between them are found 16 or 32 bytes at a time
+ * and copied at once
+ ***/
+template < CharSink Sink >
+void writeString(Sink& sink, std::string_view str) {
+    const char* pos       = str.data();
+    const char* const end = pos + str.size();
+    sink.push_back('\"');
+    while (true) {
+        // most keys and values are short, not worth the simd dispatch
+        const char* special =
+          end - pos < 16 ? _SimdScan::findStringSpecialScalar(pos, end)
+                         : _SimdScan::findStringSpecial(pos, end);
+        sink.append(pos, special - pos);
+        if (special == end) {
+            break;
+        }
+        writeEscape(sink, *special);
+        pos = special + 1;
+    }
+    sink.push_back('\"');
+}
+
+/***
+ * @description: most doubles in json have a few decimals, find the fewest
+ * k <= 6 that value * 10^k is an integer m, and write m with a point put in.
+ * m / 10^k is rounded once like the parser does, so the text reads back the
+ * same if the division gives the value back.
+ * @return char* {*}: the end of the text, nullptr if there is no such k,
+ * then std::to_chars does the general case, which is much slower
+ ***/
+inline char* writeShortDecimal(char* buffer, double value) noexcept {
+    static constexpr double pow10[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    // m is exact below 2^53
+    constexpr double max_exact = 9007199254740992.0;
+    if (value == 0 && std::signbit(value)) {
+        return nullptr; // -0
+    }
+    for (int k = 0; k < 7; ++k) {
+        double scaled = std::round(value * pow10[k]);
+        if (std::fabs(scaled) >= max_exact) {
+            return nullptr;
+        }
+        if (scaled / pow10[k] != value) {
+            continue;
+        }
+        auto m = static_cast< std::int64_t >(scaled);
+        char* pos = buffer;
+        if (m < 0) {
+            *pos++ = '-';
+            m      = -m;
+        }
+        char digits[20];
+        char* end = std::to_chars(digits, digits + sizeof(digits), m).ptr;
+        auto count = static_cast< int >(end - digits);
+        if (count <= k) {
+            // 0.00ddd
+            *pos++ = '0';
+            *pos++ = '.';
+            pos    = std::fill_n(pos, k - count, '0');
+            return std::copy(digits, end, pos);
+        }
+        pos = std::copy(digits, end - k, pos);
+        if (k > 0) {
+            *pos++ = '.';
+            pos    = std::copy(end - k, end, pos);
+        }
+        return pos;
+    }
+    return nullptr;
+}
+
+/***
+ * @description: integers exactly, doubles in the shortest form that reads
+ * back to the same value, NaN and infinity are not json so they are null
+ ***/
+template < CharSink Sink, typename T >
+    requires std::is_arithmetic_v< T >
+void writeNumber(Sink& sink, T value) {
+    char buffer[32];
+    if constexpr (std::is_floating_point_v< T >) {
+        if (!std::isfinite(value)) {
+            writeRaw(sink, "null");
+            return;
+        }
+        if (char* end = writeShortDecimal(buffer, value)) {
+            sink.append(buffer, end - buffer);
+            return;
+        }
+    }
+    auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    sink.append(buffer, res.ptr - buffer);
+}
+
+template < CharSink Sink >
+void writeUnicodeEscape(Sink& sink, char32_t code) {
+    static constexpr char hex[] = "0123456789abcdef";
+    const char text[]           = {'\\', 'u', hex[(code >> 12) & 0xF],
+      hex[(code >> 8) & 0xF], hex[(code >> 4) & 0xF], hex[code & 0xF]};
+    sink.append(text, sizeof(text));
+}
+
+// the code point of the utf-8 sequence at pos, U+FFFD for a bad one
+inline char32_t decodeUtf8(const char*& pos, const char* end) noexcept {
+    auto byte = [&](std::ptrdiff_t i) {
+        return static_cast< unsigned char >(pos[i]);
+    };
+    unsigned char lead = byte(0);
+    int count          = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : 1;
+    if (lead < 0xC0 || lead > 0xF4 || end - pos <= count) {
+        ++pos;
+        return 0xFFFD;
+    }
+    char32_t code = lead & (0x3F >> count);
+    for (int i = 1; i <= count; ++i) {
+        if ((byte(i) & 0xC0) != 0x80) {
+            ++pos;
+            return 0xFFFD;
+        }
+        code = (code << 6) | (byte(i) & 0x3F);
+    }
+    pos += count + 1;
+    return code;
+}
+
+// like writeString, and every non-ASCII char is escaped too
+template < CharSink Sink >
+void writeStringAscii(Sink& sink, std::string_view str) {
+    const char* pos       = str.data();
+    const char* const end = pos + str.size();
+    sink.push_back('\"');
+    while (pos < end) {
+        const char* plain = pos;
+        while (pos < end && static_cast< unsigned char >(*pos) < 0x80 &&
+               !_SimdScan::isStringSpecial(*pos))
+        {
+            ++pos;
+        }
+        sink.append(plain, pos - plain);
+        if (pos == end) {
+            break;
+        }
+        if (static_cast< unsigned char >(*pos) < 0x80) {
+            writeEscape(sink, *pos++);
+            continue;
+        }
+        char32_t code = decodeUtf8(pos, end);
+        if (code >= 0x10000) {
+            code -= 0x10000;
+            writeUnicodeEscape(sink, 0xD800 + (code >> 10));
+            writeUnicodeEscape(sink, 0xDC00 + (code & 0x3FF));
+        }
+        else {
+            writeUnicodeEscape(sink, code);
+        }
+    }
+    sink.push_back('\"');
+}
+
+// a new line and the indent of the depth
+template < CharSink Sink >
+void newLine(Sink& sink, const FormatOptions& options, std::size_t depth) {
+    static constexpr char spaces[] = "                                ";
+    constexpr std::size_t chunk    = sizeof(spaces) - 1;
+    sink.push_back('\n');
+    for (std::size_t count = options.indent * depth; count > 0;) {
+        std::size_t size = count < chunk ? count : chunk;
+        sink.append(spaces, size);
+        count -= size;
+    }
+}
+
+// what goes before an element of a list or object
+template < CharSink Sink >
+void beforeElement(Sink& sink, const FormatOptions& options,
+  std::size_t depth, bool first) {
+    if (!first) {
+        sink.push_back(',');
+    }
+    if (options.compact) {
+        return;
+    }
+    if (options.indent > 0) {
+        newLine(sink, options, depth + 1);
+    }
+    else if (!first) {
+        sink.push_back(' ');
+    }
+}
+
+template < CharSink Sink, typename Obj >
+void writeValue(Sink& sink, const Obj& obj, const FormatOptions& options,
+  std::size_t depth = 0);
+
+// a key of an object and what follows it
+template < CharSink Sink >
+void writeKey(Sink& sink, std::string_view key, const FormatOptions& options) {
+    if (options.ascii_only) {
+        writeStringAscii(sink, key);
+    }
+    else {
+        writeString(sink, key);
+    }
+    writeRaw(sink, options.compact ? ":" : ": ");
+}
+
+/***
+ * @description: write the members of a DictType, TJson uses it for its
+ * own map
+ ***/
+template < CharSink Sink, typename Dict >
+void writeObject(Sink& sink, const Dict& dict, const FormatOptions& options,
+  std::size_t depth = 0) {
+    if (dict.empty()) {
+        writeRaw(sink, "{}");
+        return;
+    }
+    bool first  = true;
+    auto member = [&](const auto& key, const auto& value) {
+        beforeElement(sink, options, depth, first);
+        first = false;
+        writeKey(sink, key, options);
+        writeValue(sink, value, options, depth + 1);
+    };
+    sink.push_back('{');
+    if (options.sort_keys) {
+        std::vector< const typename Dict::value_type* > members;
+        members.reserve(dict.size());
+        for (const auto& item : dict) {
+            members.push_back(&item);
+        }
+        std::sort(members.begin(), members.end(),
+          [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+        for (auto item : members) {
+            member(item->first, item->second);
+        }
+    }
+    else {
+        for (const auto& [key, value] : dict) {
+            member(key, value);
+        }
+    }
+    if (options.indent > 0 && !options.compact) {
+        newLine(sink, options, depth);
+    }
+    sink.push_back('}');
+}
+
+/***
+ * @param  sink {Sink}: the text is appended to it
+ * @param  obj {Obj}: a TJsonObj, a template so that this header does not
+ * need it
+ * @param  options {FormatOptions}: the layout, the default one puts
+ * ", " between the elements and ": " behind the keys on one line
+ * @param  depth {std::size_t}: how deep obj is, for the indent
+ ***/
+template < CharSink Sink, typename Obj >
+void writeValue(Sink& sink, const Obj& obj, const FormatOptions& options,
+  std::size_t depth) {
+    std::visit(
+      [&](const auto& arg) {
+          using T = std::decay_t< decltype(arg) >;
+          if constexpr (std::is_same_v< T, std::monostate >) {
+              writeRaw(sink, "null");
+          }
+          else if constexpr (std::is_same_v< T, typename Obj::StringType > ||
+                             std::is_same_v< T, std::string_view >)
+          {
+              if (options.ascii_only) {
+                  writeStringAscii(sink, arg);
+              }
+              else {
+                  writeString(sink, arg);
+              }
+          }
+          else if constexpr (std::is_same_v< T, bool >) {
+              writeRaw(sink, arg ? "true" : "false");
+          }
+          else if constexpr (std::is_arithmetic_v< T >) {
+              writeNumber(sink, arg);
+          }
+          else if constexpr (std::is_same_v< T, typename Obj::ListType >) {
+              if (arg.empty()) {
+                  writeRaw(sink, "[]");
+                  return;
+              }
+              sink.push_back('[');
+              for (auto it = arg.begin(); it != arg.end(); ++it) {
+                  beforeElement(sink, options, depth, it == arg.begin());
+                  writeValue(sink, *it, options, depth + 1);
+              }
+              if (options.indent > 0 && !options.compact) {
+                  newLine(sink, options, depth);
+              }
+              sink.push_back(']');
+          }
+          else if constexpr (std::is_same_v< T, typename Obj::DictType >) {
+              writeObject(sink, arg, options, depth);
+          }
+          else {
+              // RawNumber, the text in source
+              writeRaw(sink, arg.str);
+          }
+      },
+      obj.get());
+}
+
+// on one line with the default layout
+template < CharSink Sink, typename Obj >
+void writeValue(Sink& sink, const Obj& obj) {
+    writeValue(sink, obj, FormatOptions{});
+}
+
+} // namespace _Serializer
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_SERIALIZER_HPP__
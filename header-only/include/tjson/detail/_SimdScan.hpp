@@ -0,0 +1,364 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-21T09:40:05
+ * @lastmod: 2024-07-21T09:40:05
+ * @description: scan many bytes at once with SSE2/AVX2, scalar elsewhere
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/detail/_SimdScan.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_SIMD_SCAN_HPP__
+#define __TJSON_SIMD_SCAN_HPP__
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define __TJSON_X86__ 1
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+namespace _SimdScan {
+
+// a char that stops a json string body, " \ or a control char
+inline bool isStringSpecial(char ch) noexcept {
+    return ch == '"' || ch == '\\' || static_cast< unsigned char >(ch) < 0x20;
+}
+
+inline const char* findStringSpecialScalar(
+  const char* begin, const char* end) noexcept {
+    for (; begin < end; ++begin) {
+        if (isStringSpecial(*begin)) {
+            break;
+        }
+    }
+    return begin;
+}
+
+#ifdef __TJSON_X86__
+
+__attribute__((target("sse2"))) inline const char* findStringSpecialSse2(
+  const char* begin, const char* end) noexcept {
+    const __m128i quote  = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctrl   = _mm_set1_epi8(0x1F);
+    for (; end - begin >= 16; begin += 16) {
+        __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast< const __m128i* >(begin));
+        __m128i hit = _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, bslash));
+        // unsigned chunk <= 0x1F
+        hit = _mm_or_si128(
+          hit, _mm_cmpeq_epi8(_mm_min_epu8(chunk, ctrl), chunk));
+        if (int mask = _mm_movemask_epi8(hit)) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return findStringSpecialScalar(begin, end);
+}
+
+__attribute__((target("avx2"))) inline const char* findStringSpecialAvx2(
+  const char* begin, const char* end) noexcept {
+    const __m256i quote  = _mm256_set1_epi8('"');
+    const __m256i bslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl   = _mm256_set1_epi8(0x1F);
+    for (; end - begin >= 32; begin += 32) {
+        __m256i chunk =
+          _mm256_loadu_si256(reinterpret_cast< const __m256i* >(begin));
+        __m256i hit = _mm256_or_si256(
+          _mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, bslash));
+        hit = _mm256_or_si256(
+          hit, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, ctrl), chunk));
+        if (unsigned mask = _mm256_movemask_epi8(hit)) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return findStringSpecialSse2(begin, end);
+}
+
+inline bool hasAvx2() noexcept {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif // __TJSON_X86__
+
+/***
+ * @description: the first ", \ or control char in [begin, end), end if
+ * there is none, 16 or 32 bytes are checked at a time on x86
+ ***/
+inline const char* findStringSpecial(
+  const char* begin, const char* end) noexcept {
+#ifdef __TJSON_X86__
+    return hasAvx2() ? findStringSpecialAvx2(begin, end)
+                     : findStringSpecialSse2(begin, end);
+#else
+    return findStringSpecialScalar(begin, end);
+#endif
+}
+
+/***
+ * @description: stage 1 of the two stage parser, the bit i of each mask is
+ * set if the char i of a 64 bytes block is that kind
+ ***/
+struct _BlockMasks {
+    std::uint64_t quote;     // "
+    std::uint64_t backslash; // \ escape
+    std::uint64_t space;     // ' ' \t \n \r
+    std::uint64_t op;        // { } [ ] : ,
+    std::uint64_t open;      // { [
+    std::uint64_t close;     // } ]
+};
+
+inline _BlockMasks classifyScalar(const char* block) noexcept {
+    _BlockMasks masks{};
+    for (int i = 0; i < 64; ++i) {
+        std::uint64_t bit = std::uint64_t{1} << i;
+        switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                masks.space |= bit;
+                break;
+            case '{':
+            case '[':
+                masks.open |= bit;
+                masks.op |= bit;
+                break;
+            case '}':
+            case ']':
+                masks.close |= bit;
+                masks.op |= bit;
+                break;
+            case ':':
+            case ',':
+                masks.op |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+    return masks;
+}
+
+#ifdef __TJSON_X86__
+
+__attribute__((target("sse2"))) inline _BlockMasks classifySse2(
+  const char* block) noexcept {
+    _BlockMasks masks{};
+    auto eq = [](__m128i chunk, char ch) {
+        return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(ch));
+    };
+    auto bits = [](__m128i hit, int shift) {
+        return static_cast< std::uint64_t >(
+                 static_cast< std::uint16_t >(_mm_movemask_epi8(hit)))
+            << shift;
+    };
+    for (int i = 0; i < 64; i += 16) {
+        __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast< const __m128i* >(block + i));
+        masks.quote |= bits(eq(chunk, '"'), i);
+        masks.backslash |= bits(eq(chunk, '\\'), i);
+        masks.space |= bits(
+          _mm_or_si128(_mm_or_si128(eq(chunk, ' '), eq(chunk, '\t')),
+            _mm_or_si128(eq(chunk, '\n'), eq(chunk, '\r'))),
+          i);
+        // { and } differ from [ and ] by 0x20, fold them with | 0x20
+        __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        __m128i open   = eq(folded, '{');
+        __m128i close  = eq(folded, '}');
+        masks.open |= bits(open, i);
+        masks.close |= bits(close, i);
+        masks.op |= bits(_mm_or_si128(_mm_or_si128(open, close),
+                           _mm_or_si128(eq(chunk, ':'), eq(chunk, ','))),
+          i);
+    }
+    return masks;
+}
+
+__attribute__((target("avx2"))) inline __m256i eqAvx2(
+  __m256i chunk, char ch) noexcept {
+    return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(ch));
+}
+
+__attribute__((target("avx2"))) inline std::uint64_t bitsAvx2(
+  __m256i hit, int shift) noexcept {
+    return static_cast< std::uint64_t >(
+             static_cast< std::uint32_t >(_mm256_movemask_epi8(hit)))
+        << shift;
+}
+
+__attribute__((target("avx2"))) inline _BlockMasks classifyAvx2(
+  const char* block) noexcept {
+    _BlockMasks masks{};
+    for (int i = 0; i < 64; i += 32) {
+        __m256i chunk =
+          _mm256_loadu_si256(reinterpret_cast< const __m256i* >(block + i));
+        masks.quote |= bitsAvx2(eqAvx2(chunk, '"'), i);
+        masks.backslash |= bitsAvx2(eqAvx2(chunk, '\\'), i);
+        masks.space |= bitsAvx2(
+          _mm256_or_si256(
+            _mm256_or_si256(eqAvx2(chunk, ' '), eqAvx2(chunk, '\t')),
+            _mm256_or_si256(eqAvx2(chunk, '\n'), eqAvx2(chunk, '\r'))),
+          i);
+        __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        __m256i open   = eqAvx2(folded, '{');
+        __m256i close  = eqAvx2(folded, '}');
+        masks.open |= bitsAvx2(open, i);
+        masks.close |= bitsAvx2(close, i);
+        masks.op |= bitsAvx2(
+          _mm256_or_si256(_mm256_or_si256(open, close),
+            _mm256_or_si256(eqAvx2(chunk, ':'), eqAvx2(chunk, ','))),
+          i);
+    }
+    return masks;
+}
+
+#endif // __TJSON_X86__
+
+// bit i is the xor of the bits 0..i, marks the chars inside quotes
+inline std::uint64_t prefixXor(std::uint64_t bits) noexcept {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/***
+ * @description: which chars of each 64 bytes block are inside a json
+ * string, the blocks are given in order and what the last one leaves open
+ * is carried to the next
+ ***/
+struct _StringTracker {
+    // all ones if the last block ends in a string
+    std::uint64_t in_string_carry = 0;
+    // the last block ends with a backslash that escapes the first char
+    bool escape_carry = false;
+
+    /***
+     * @return: the unescaped quotes of the block, and the chars inside the
+     * strings, the opening quote is inside and the closing one is not
+     ***/
+    std::pair< std::uint64_t, std::uint64_t > next(
+      const _BlockMasks& masks) noexcept {
+        // the chars behind an unescaped \ are escaped, \ is rare so this
+        // walks the bits one by one
+        std::uint64_t escaped   = 0;
+        std::uint64_t backslash = masks.backslash;
+        if (escape_carry) {
+            escaped |= 1;
+            backslash &= ~std::uint64_t{1};
+        }
+        escape_carry = false;
+        while (backslash) {
+            int bit = std::countr_zero(backslash);
+            if (bit == 63) {
+                escape_carry = true;
+                break;
+            }
+            escaped |= std::uint64_t{1} << (bit + 1);
+            backslash &= ~(std::uint64_t{3} << bit);
+        }
+
+        std::uint64_t quote     = masks.quote & ~escaped;
+        std::uint64_t in_string = prefixXor(quote) ^ in_string_carry;
+        in_string_carry         = static_cast< std::uint64_t >(
+          -static_cast< std::int64_t >(in_string >> 63));
+        return {quote, in_string};
+    }
+};
+
+// classify the block at base, the tail is padded with white space
+inline _BlockMasks classifyAt(const std::string_view json_str,
+  std::size_t base, _BlockMasks (*classify)(const char*) noexcept) {
+    if (json_str.size() - base >= 64) {
+        return classify(json_str.data() + base);
+    }
+    char block[64];
+    std::fill(std::begin(block), std::end(block), ' ');
+    std::copy(json_str.begin() + base, json_str.end(), block);
+    return classify(block);
+}
+
+// the widest classifier the cpu supports, picked at runtime
+inline auto bestClassify() noexcept -> _BlockMasks (*)(const char*) noexcept {
+#ifdef __TJSON_X86__
+    return hasAvx2() ? classifyAvx2 : classifySse2;
+#else
+    return classifyScalar;
+#endif
+}
+
+/***
+ * @description: the positions where a json token begins, that is every
+ * { } [ ] : , and opening " outside the strings, and the first char of
+ * each number or literal, white space is never in it
+ * @param index {std::vector<std::uint32_t>}: the positions are appended
+ * @param classify {*}: how a 64 bytes block is classified
+ ***/
+inline void buildStructuralIndex(const std::string_view json_str,
+  std::vector< std::uint32_t >& index,
+  _BlockMasks (*classify)(const char*) noexcept) {
+    _StringTracker strings;
+    // 1 if the last block ends in a number or literal
+    std::uint64_t scalar_carry = 0;
+
+    for (std::size_t base = 0; base < json_str.size(); base += 64) {
+        _BlockMasks masks = classifyAt(json_str, base, classify);
+        auto [quote, in_string] = strings.next(masks);
+
+        // the opening quote is in string, the closing one is not
+        std::uint64_t structural =
+          (masks.op & ~in_string) | (quote & in_string);
+        std::uint64_t scalar = ~(masks.op | masks.space | quote | in_string);
+        structural |= scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        while (structural) {
+            index.push_back(static_cast< std::uint32_t >(
+              base + std::countr_zero(structural)));
+            structural &= structural - 1;
+        }
+    }
+}
+
+/***
+ * @description: build the structural index with the widest simd the cpu
+ * supports, picked at runtime
+ ***/
+inline void buildStructuralIndex(
+  const std::string_view json_str, std::vector< std::uint32_t >& index) {
+    index.reserve(index.size() + json_str.size() / 4);
+    buildStructuralIndex(json_str, index, bestClassify());
+}
+
+} // namespace _SimdScan
+
+} // namespace __detail
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_SIMD_SCAN_HPP__
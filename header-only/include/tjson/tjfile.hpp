@@ -11,13 +11,18 @@
 #ifndef __TJSON_FILE_HPP__
 #define __TJSON_FILE_HPP__
 
+#include <concepts>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <type_traits>
 
+#include "detail/_FileBuffer.hpp"
 #include "detail/_ParserScan.hpp"
 #include "tjson.hpp"
 #include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonWriter.hpp"
 
 namespace lap {
 
@@ -27,36 +32,13 @@ namespace tjson {
 class TJsonFile {
   private:
     std::filesystem::path m_path;
+    // what readJsonFile read, m_json_str is what is dumped instead
+    __detail::_FileBuffer m_file;
     std::string m_json_str;
 
-  protected:
-  public:
-    TJsonFile() : m_path(std::filesystem::current_path()) {}
-
-    TJsonFile(const std::filesystem::path& path) : m_path(path) {}
-
-    bool readJsonFile() { return readJsonFile(m_path); }
-
-    bool readJsonFile(const std::filesystem::path& path) {
-        std::ifstream ifs(path, std::ios::in);
-        std::cout << std::format(
-          "\033[1;33mreading\033[0m: {}\n", path.string());
-        if (ifs.is_open()) {
-            std::string line;
-            std::string reads;
-            while (std::getline(ifs, line)) {
-                reads.append(line);
-            }
-            m_json_str = std::move(reads);
-            ifs.close();
-            return true;
-        }
-        throw std::runtime_error("\033[1;31mfile not found\033[0m");
-    }
-
-    std::string getJsonStr() const { return m_json_str; }
-
-    bool storeJsonStr2Where(const std::filesystem::path& path) const {
+    // write text to path, or to tjson.json in it if it is not a .json file
+    bool storeText(
+      const std::filesystem::path& path, std::string_view text) const {
         std::ofstream ofs("", std::ios::out | std::ios::trunc);
         if (path.string().ends_with(".json")) {
             ofs.open(path);
@@ -70,7 +52,7 @@ class TJsonFile {
               "\033[1;33mstore to\033[0m : {}\n", std::move(default_path));
         }
 
-        ofs << __detail::_ParserScan::unescapeString(m_json_str);
+        ofs.write(text.data(), text.size());
 
         if (!ofs) {
             throw std::runtime_error(std::format(
@@ -79,15 +61,93 @@ class TJsonFile {
         return true;
     }
 
+  protected:
+  public:
+    TJsonFile() : m_path(std::filesystem::current_path()) {}
+
+    TJsonFile(const std::filesystem::path& path) : m_path(path) {}
+
+    bool readJsonFile() { return readJsonFile(m_path); }
+
+    /***
+     * @description: a regular file is mapped and parsed in place, see
+     * getJsonView, the new lines are kept
+     * @exception: std::runtime_error if the file can't be read
+     ***/
+    bool readJsonFile(const std::filesystem::path& path) {
+        std::cout << std::format(
+          "\033[1;33mreading\033[0m: {}\n", path.string());
+        m_file = __detail::_FileBuffer{path};
+        m_json_str.clear();
+        return true;
+    }
+
+    std::string getJsonStr() const { return std::string{getJsonView()}; }
+
+    /***
+     * @description: the bytes read by readJsonFile without copying them,
+     * valid until the next read or dump, parse it with TJson::setJsonView
+     * or Parser::setView
+     ***/
+    std::string_view getJsonView() const {
+        return m_json_str.empty() ? m_file.view() : m_json_str;
+    }
+
+    bool storeJsonStr2Where(const std::filesystem::path& path) const {
+        // the bytes as read, new lines and escapes included
+        return storeText(path, getJsonView());
+    }
+
     bool storeJsonStr2Where() const { return storeJsonStr2Where(m_path); }
 
+    /***
+     * @description: dump the json text to the file, it is kept as
+     * m_json_str, see getJsonView
+     * @param  options {FormatOptions}: the layout, with threads a large
+     * tree is written on many threads
+     ***/
     template < typename T >
         requires(std::is_same_v< T, TJsonObj > || std::is_same_v< T, TJson >)
-    bool dumpJsonObj2File(
-      const T& json_obj, const std::filesystem::path& path = "") {
-        m_json_str = std::move(json_obj.toString());
-        return *path.c_str() == '\0' ? storeJsonStr2Where()
-                                     : storeJsonStr2Where(path);
+    bool dumpJsonObj2File(const T& json_obj,
+      const std::filesystem::path& path = "",
+      const FormatOptions& options      = {}) {
+        m_json_str = json_obj.toString(options);
+        m_file     = {};
+        // already escaped, the new lines of an indent are kept
+        return storeText(*path.c_str() == '\0' ? m_path : path, m_json_str);
+    }
+
+    /***
+     * @description: write the file through a Writer, the json is never
+     * held in memory as a whole, m_json_str is not changed
+     * @param  write {Callable}: called with the Writer< FileSink >&
+     * @exception: std::runtime_error if the file can't be written or a
+     * list or object is left open
+     ***/
+    template < std::invocable< Writer< FileSink >& > Callable >
+    bool writeJsonFile(const std::filesystem::path& path, Callable&& write) {
+        std::unique_ptr< std::FILE, int (*)(std::FILE*) > file{
+          std::fopen(path.c_str(), "wb"), &std::fclose};
+        if (!file) {
+            throw std::runtime_error(std::format(
+              "\033[1;31m{}\033[0m", "Failed to write file: " + path.string()));
+        }
+        std::cout << std::format(
+          "\033[1;33mstore to\033[0m : {}\n", path.string());
+        {
+            Writer writer{FileSink{file.get()}};
+            write(writer);
+            writer.flush();
+            if (!writer.complete()) {
+                throw std::runtime_error(
+                  "\033[1;31mthe json written is not complete\033[0m");
+            }
+        }
+        if (std::fclose(file.release()) != 0) {
+            throw std::runtime_error(std::format(
+              "\033[1;31m{}\033[0m", "Failed to write file: " + path.string()));
+        }
+        return true;
     }
 };
 
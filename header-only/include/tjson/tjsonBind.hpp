@@ -0,0 +1,567 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-08-05T14:02:51
+ * @lastmod: 2024-08-05T14:02:51
+ * @description: read json straight into a struct and write a struct
+ * straight to json, the fields are described once with TJSON_FIELDS
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonBind.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_BIND_HPP__
+#define __TJSON_BIND_HPP__
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/detail/_Serializer.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+#include "tjson/tjsonSax.hpp"
+
+// each rescan expands one more field, 256 in all
+#define TJSON_PARENS ()
+#define TJSON_EXPAND(...)                                                      \
+    TJSON_EXPAND4(TJSON_EXPAND4(TJSON_EXPAND4(TJSON_EXPAND4(__VA_ARGS__))))
+#define TJSON_EXPAND4(...)                                                     \
+    TJSON_EXPAND3(TJSON_EXPAND3(TJSON_EXPAND3(TJSON_EXPAND3(__VA_ARGS__))))
+#define TJSON_EXPAND3(...)                                                     \
+    TJSON_EXPAND2(TJSON_EXPAND2(TJSON_EXPAND2(TJSON_EXPAND2(__VA_ARGS__))))
+#define TJSON_EXPAND2(...)                                                     \
+    TJSON_EXPAND1(TJSON_EXPAND1(TJSON_EXPAND1(TJSON_EXPAND1(__VA_ARGS__))))
+#define TJSON_EXPAND1(...) __VA_ARGS__
+
+#define TJSON_FIELD_OF(Type, member)                                           \
+    ::lap::tjson::Field< &Type::member > { #member }
+#define TJSON_FIELDS_HELPER(Type, member, ...)                                 \
+    TJSON_FIELD_OF(Type, member)                                               \
+    __VA_OPT__(, TJSON_FIELDS_AGAIN TJSON_PARENS(Type, __VA_ARGS__))
+#define TJSON_FIELDS_AGAIN() TJSON_FIELDS_HELPER
+
+/***
+ * @description: describe the fields of a struct once, in the namespace of
+ * the struct, the key of each field is its name
+ * @example:
+ *   struct User { int id; std::string name; };
+ *   TJSON_FIELDS(User, id, name)
+ ***/
+#define TJSON_FIELDS(Type, ...)                                                \
+    constexpr auto tjsonFields(const Type*) {                                  \
+        return std::tuple{                                                     \
+          __VA_OPT__(TJSON_EXPAND(TJSON_FIELDS_HELPER(Type, __VA_ARGS__)))};   \
+    }
+
+namespace lap {
+
+namespace tjson {
+
+/***
+ * @description: a member of a struct and its key, TJSON_FIELDS makes them,
+ * or write tjsonFields by hand for other keys:
+ *   constexpr auto tjsonFields(const User*) {
+ *       return std::tuple{Field< &User::id >{"user-id"}};
+ *   }
+ ***/
+template < auto Member >
+struct Field {
+    static constexpr auto member = Member;
+    std::string_view name;
+};
+
+namespace __detail {
+
+namespace _Bind {
+
+// a struct with tjsonFields, found by ADL
+template < typename T >
+concept Mapped = requires(const T* ptr) { tjsonFields(ptr); };
+
+template < Mapped T >
+inline constexpr auto fieldsOf = tjsonFields(static_cast< const T* >(nullptr));
+
+template < typename T >
+struct _IsOptional : std::false_type {};
+
+template < typename T >
+struct _IsOptional< std::optional< T > > : std::true_type {};
+
+template < typename T >
+concept StringLike = requires(T& str, std::string_view view) {
+    str.assign(view);
+    std::string_view{str};
+};
+
+template < typename T >
+concept MapLike = requires(T& map) {
+    typename T::key_type;
+    typename T::mapped_type;
+    map.clear();
+} && std::is_constructible_v< typename T::key_type, std::string_view >;
+
+template < typename T >
+concept ListLike = requires(T& list) {
+    list.emplace_back();
+    list.clear();
+    list.begin();
+    list.end();
+};
+
+// up to 8 bytes of str as one little-endian word, so that the hashes of
+// compile time and run time agree; memcpy only where that is the native
+// order, byte by byte elsewhere and while constant evaluated
+constexpr std::uint64_t loadWord(const char* str, std::size_t size) noexcept {
+    std::uint64_t word = 0;
+    if (std::is_constant_evaluated()
+        || std::endian::native != std::endian::little)
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            word |= std::uint64_t{static_cast< unsigned char >(str[i])}
+                 << (8 * i);
+        }
+    }
+    else {
+        std::memcpy(&word, str, size);
+    }
+    return word;
+}
+
+// the key folded 8 bytes at a time with its length
+constexpr std::uint64_t foldKey(std::string_view key) noexcept {
+    std::uint64_t hash = key.size();
+    for (std::size_t i = 0; i < key.size(); i += 8) {
+        std::size_t size = key.size() - i < 8 ? key.size() - i : 8;
+        hash = (hash ^ loadWord(key.data() + i, size)) * 0x9E3779B97F4A7C15;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// how a folded key is put in a slot of the perfect hash
+struct _HashPlan {
+    unsigned bits;
+    std::uint64_t multiplier;
+
+    constexpr std::size_t slot(std::uint64_t hash) const noexcept {
+        return bits == 0 ? 0 : (hash * multiplier) >> (64 - bits);
+    }
+};
+
+// the fewest bits and a multiplier that put each name in its own slot
+template < std::size_t N >
+constexpr std::optional< _HashPlan > findPlan(
+  const std::array< std::string_view, N >& names) {
+    constexpr unsigned least = std::bit_width(N);
+    for (unsigned bits = least; bits < least + 4; ++bits) {
+        for (std::uint64_t seed = 0; seed < 1024; ++seed) {
+            _HashPlan plan{
+              bits, (seed * 0xBF58476D1CE4E5B9 + 0x94D049BB133111EB) | 1};
+            std::array< bool, (std::size_t{1} << (least + 3)) > used{};
+            bool ok = true;
+            for (std::string_view name : names) {
+                std::size_t slot = plan.slot(foldKey(name));
+                ok               = ok && !used[slot];
+                used[slot]       = true;
+            }
+            if (ok) {
+                return plan;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/***
+ * @description: a perfect hash of the field names found at compile time,
+ * a key is one fold, one multiply and one compare with the only name that
+ * may match
+ ***/
+template < Mapped T >
+class _FieldTable {
+  public:
+    static constexpr std::size_t count =
+      std::tuple_size_v< std::remove_const_t< decltype(fieldsOf< T >) > >;
+
+  private:
+    static constexpr std::array< std::string_view, count > names =
+      std::apply(
+        [](const auto&... field) {
+            return std::array< std::string_view, count >{field.name...};
+        },
+        fieldsOf< T >);
+
+    static constexpr std::optional< _HashPlan > plan = findPlan(names);
+    static_assert(plan.has_value(), "two fields have the same key");
+
+    // the index of the name in each slot plus one, 0 if none
+    static constexpr auto slots = []() {
+        std::array< std::uint16_t, (std::size_t{1} << plan->bits) > res{};
+        for (std::size_t i = 0; i < count; ++i) {
+            res[plan->slot(foldKey(names[i]))] =
+              static_cast< std::uint16_t >(i + 1);
+        }
+        return res;
+    }();
+
+  public:
+    // the index of the field of the key, count if there is none
+    static std::size_t find(std::string_view key) noexcept {
+        std::size_t index = slots[plan->slot(foldKey(key))];
+        return index != 0 && names[index - 1] == key ? index - 1 : count;
+    }
+};
+
+// reads the json at the cursor into a value, no tree in between
+class _Reader {
+  private:
+    std::string_view m_json;
+    std::size_t m_reads = 0;
+    _TJsonToken::Type m_state{};
+    _ParserScan::_ScanContext m_ctx;
+
+    [[noreturn]] void expect(std::string_view what) const {
+        throw std::invalid_argument(
+          std::format("\033[1;31mexpect {} at {}\033[0m", what, m_reads));
+    }
+
+    template < typename T >
+    T readNumber() {
+        if (m_state != _TJsonToken::VALUE_NUMBER) {
+            expect("a number");
+        }
+        std::size_t begin = m_reads;
+        auto span         = _ParserScan::scanNumber(m_json, m_reads);
+        if (auto value = _ParserScan::tryParse< T >(span.str)) {
+            return *value;
+        }
+        throw std::invalid_argument(
+          std::format("\033[1;31m{} does not fit the field at {}\033[0m",
+            span.str, begin));
+    }
+
+    // the members of an object, each value is read by onMember(key), the
+    // key is only valid until then
+    template < typename OnMember >
+    void readObject(OnMember&& onMember) {
+        if (m_state != _TJsonToken::BEGIN_OBJECT) {
+            expect("{");
+        }
+        ++m_reads; // skip {
+        next();
+        if (m_state == _TJsonToken::END_OBJECT) {
+            ++m_reads;
+            return;
+        }
+        while (true) {
+            if (m_state != _TJsonToken::VALUE_STRING) {
+                expect("a string key");
+            }
+            std::string_view key = _ParserScan::decodeString(
+              _ParserScan::scanString(m_json, m_reads), m_ctx);
+            next();
+            if (m_state != _TJsonToken::NAME_SEPRATOR) {
+                expect(":");
+            }
+            ++m_reads; // skip :
+            next();
+            onMember(key);
+            next();
+            if (m_state == _TJsonToken::END_OBJECT) {
+                ++m_reads;
+                return;
+            }
+            if (m_state != _TJsonToken::VALUE_SEPRATOR) {
+                expect(", or }");
+            }
+            ++m_reads; // skip ,
+            next();
+        }
+    }
+
+    template < typename OnElement >
+    void readList(OnElement&& onElement) {
+        if (m_state != _TJsonToken::LIST_BEGIN) {
+            expect("[");
+        }
+        ++m_reads; // skip [
+        next();
+        if (m_state == _TJsonToken::LIST_END) {
+            ++m_reads;
+            return;
+        }
+        while (true) {
+            onElement();
+            next();
+            if (m_state == _TJsonToken::LIST_END) {
+                ++m_reads;
+                return;
+            }
+            if (m_state != _TJsonToken::VALUE_SEPRATOR) {
+                expect(", or ]");
+            }
+            ++m_reads; // skip ,
+            next();
+        }
+    }
+
+    // a value of an unknown key, checked but not kept
+    void skip() {
+        SaxHandlerBase skipper;
+        _ParserScan::scanValue(m_json, m_state, m_reads, m_ctx, skipper);
+    }
+
+  public:
+    _Reader(std::string_view json_str, const ParseOptions& options)
+      : m_json{json_str}, m_ctx{options} {
+        if (!m_ctx.opts.resource) {
+            m_ctx.opts.resource = std::pmr::get_default_resource();
+        }
+    }
+
+    // skip the white space, the state is the token at the cursor
+    void next() {
+        _ParserScan::update_state(m_json, m_state, m_reads, m_ctx);
+    }
+
+    bool atEnd() const { return m_reads >= m_json.size(); }
+
+    std::size_t pos() const { return m_reads; }
+
+    template < typename T >
+    void read(T& value);
+};
+
+// the readers of the fields of T, by index
+template < Mapped T >
+inline constexpr auto fieldReaders = []< std::size_t... I >(
+                                       std::index_sequence< I... >) {
+    return std::array< void (*)(_Reader&, T&), sizeof...(I) >{
+      +[](_Reader& reader, T& value) {
+          using Fields = std::remove_const_t< decltype(fieldsOf< T >) >;
+          reader.read(value.*std::tuple_element_t< I, Fields >::member);
+      }...};
+}(std::make_index_sequence< _FieldTable< T >::count >{});
+
+/***
+ * @description: read the json value at the cursor into value. A struct of
+ * TJSON_FIELDS skips the unknown keys and keeps the fields that are
+ * missing, an optional is reset by null, a list or map is cleared first
+ * @exception: std::invalid_argument if the json does not match the type
+ ***/
+template < typename T >
+void _Reader::read(T& value) {
+    if constexpr (std::is_same_v< T, TJsonObj >) {
+        _DomHandler dom{m_ctx.opts.resource, m_json, false};
+        _ParserScan::scanValue(m_json, m_state, m_reads, m_ctx, dom);
+        value = dom.take();
+    }
+    else if constexpr (Mapped< T >) {
+        readObject([&](std::string_view key) {
+            std::size_t index = _FieldTable< T >::find(key);
+            if (index == _FieldTable< T >::count) {
+                skip();
+            }
+            else {
+                fieldReaders< T >[index](*this, value);
+            }
+        });
+    }
+    else if constexpr (std::is_same_v< T, bool >) {
+        if (m_state == _TJsonToken::LITERAL_TRUE) {
+            _ParserScan::expectLiteral(m_json, m_reads, "true");
+            value = true;
+        }
+        else if (m_state == _TJsonToken::LITERAL_FALSE) {
+            _ParserScan::expectLiteral(m_json, m_reads, "false");
+            value = false;
+        }
+        else {
+            expect("true or false");
+        }
+    }
+    else if constexpr (std::is_arithmetic_v< T >) {
+        value = readNumber< T >();
+    }
+    else if constexpr (StringLike< T >) {
+        if (m_state != _TJsonToken::VALUE_STRING) {
+            expect("a string");
+        }
+        value.assign(_ParserScan::decodeString(
+          _ParserScan::scanString(m_json, m_reads), m_ctx));
+    }
+    else if constexpr (_IsOptional< T >::value) {
+        if (m_state == _TJsonToken::LITERAL_NULL) {
+            _ParserScan::expectLiteral(m_json, m_reads, "null");
+            value.reset();
+        }
+        else {
+            read(value.emplace());
+        }
+    }
+    else if constexpr (MapLike< T >) {
+        value.clear();
+        readObject([&](std::string_view key) {
+            typename T::key_type owned(key);
+            read(value[std::move(owned)]);
+        });
+    }
+    else if constexpr (ListLike< T >) {
+        value.clear();
+        readList([&]() { read(value.emplace_back()); });
+    }
+    else {
+        static_assert(!sizeof(T), "the type has no json mapping");
+    }
+}
+
+/***
+ * @description: write value as json, the fields of a struct in their
+ * order, an empty optional as null
+ ***/
+template < _Serializer::CharSink Sink, typename T >
+void write(
+  Sink& sink, const T& value, const FormatOptions& options, std::size_t depth) {
+    using namespace _Serializer;
+    if constexpr (std::is_same_v< T, TJsonObj >) {
+        writeValue(sink, value, options, depth);
+    }
+    else if constexpr (Mapped< T >) {
+        if constexpr (_FieldTable< T >::count == 0) {
+            writeRaw(sink, "{}");
+        }
+        else {
+            sink.push_back('{');
+            std::apply(
+              [&](const auto&... field) {
+                  bool first = true;
+                  ((beforeElement(sink, options, depth, first),
+                     first = false, writeKey(sink, field.name, options),
+                     write(sink, value.*field.member, options, depth + 1)),
+                    ...);
+              },
+              fieldsOf< T >);
+            if (options.indent > 0 && !options.compact) {
+                newLine(sink, options, depth);
+            }
+            sink.push_back('}');
+        }
+    }
+    else if constexpr (std::is_same_v< T, bool >) {
+        writeRaw(sink, value ? "true" : "false");
+    }
+    else if constexpr (std::is_arithmetic_v< T >) {
+        writeNumber(sink, value);
+    }
+    else if constexpr (StringLike< T >) {
+        if (options.ascii_only) {
+            writeStringAscii(sink, std::string_view{value});
+        }
+        else {
+            writeString(sink, std::string_view{value});
+        }
+    }
+    else if constexpr (_IsOptional< T >::value) {
+        if (value) {
+            write(sink, *value, options, depth);
+        }
+        else {
+            writeRaw(sink, "null");
+        }
+    }
+    else if constexpr (MapLike< T > || ListLike< T >) {
+        constexpr bool is_map = MapLike< T >;
+        if (value.begin() == value.end()) {
+            writeRaw(sink, is_map ? "{}" : "[]");
+            return;
+        }
+        sink.push_back(is_map ? '{' : '[');
+        bool first = true;
+        for (const auto& item : value) {
+            beforeElement(sink, options, depth, first);
+            first = false;
+            if constexpr (is_map) {
+                writeKey(sink, std::string_view{item.first}, options);
+                write(sink, item.second, options, depth + 1);
+            }
+            else {
+                write(sink, item, options, depth + 1);
+            }
+        }
+        if (options.indent > 0 && !options.compact) {
+            newLine(sink, options, depth);
+        }
+        sink.push_back(is_map ? '}' : ']');
+    }
+    else {
+        static_assert(!sizeof(T), "the type has no json mapping");
+    }
+}
+
+} // namespace _Bind
+
+} // namespace __detail
+
+/***
+ * @description: read a json string straight into value, no TJsonObj is
+ * built but for the fields that are one. The fields of a TJSON_FIELDS
+ * struct are matched by a perfect hash of their keys made at compile time.
+ * @param  value {T}: a TJSON_FIELDS struct, bool, a number, a string,
+ * std::optional, a list like std::vector, a map with string keys, or
+ * TJsonObj, nested as deep as you like
+ * @param  options {ParseOptions}: raw_number and resource apply to the
+ * TJsonObj fields
+ * @exception: std::invalid_argument if the json does not match the type,
+ * with the position
+ ***/
+template < typename T >
+void fromJson(
+  std::string_view json_str, T& value, const ParseOptions& options = {}) {
+    __detail::_Bind::_Reader reader{json_str, options};
+    reader.next();
+    reader.read(value);
+    reader.next();
+    if (!reader.atEnd()) {
+        throw std::invalid_argument(
+          std::format("\033[1;31munexpected character {} at {}\033[0m",
+            json_str.substr(reader.pos(), 1), reader.pos()));
+    }
+}
+
+template < typename T >
+T fromJson(std::string_view json_str, const ParseOptions& options = {}) {
+    T value{};
+    fromJson(json_str, value, options);
+    return value;
+}
+
+// write value as json straight into a std::string or any CharSink
+template < __detail::_Serializer::CharSink Sink, typename T >
+void writeJson(Sink& sink, const T& value, const FormatOptions& options = {}) {
+    __detail::_Bind::write(sink, value, options, 0);
+}
+
+template < typename T >
+std::string toJson(const T& value, const FormatOptions& options = {}) {
+    std::string res;
+    writeJson(res, value, options);
+    return res;
+}
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_BIND_HPP__
@@ -0,0 +1,581 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-08-02T10:17:44
+ * @lastmod: 2024-08-02T10:17:44
+ * @description: a json document read on demand, only the structure is
+ * checked up front and a value is parsed when it is accessed
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonLazy.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_LAZY_HPP__
+#define __TJSON_LAZY_HPP__
+
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/detail/_SimdScan.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+namespace __detail {
+
+/***
+ * @description: the tokens of a document from stage 1 of the two stage
+ * parser, linked in the same pass that checks them. The link of a { or [
+ * is its } or ] with kOpen set, the link of the first token of an element
+ * or member is the first token of the next one, or the close of the
+ * container for the last. The next of a { or [ element is in the link of
+ * its close. So a value is skipped in one or two steps, without reading
+ * the json string, whatever it holds.
+ ***/
+struct _LazyIndex {
+    static constexpr std::uint32_t kOpen = std::uint32_t{1} << 31;
+
+    std::string_view json;
+    // where each token begins, see _SimdScan::buildStructuralIndex
+    std::vector< std::uint32_t > pos;
+    std::vector< std::uint32_t > link;
+
+    char head(std::uint32_t token) const { return json[pos[token]]; }
+
+    bool isOpen(std::uint32_t token) const { return link[token] & kOpen; }
+
+    // the } or ] of the { or [ at token
+    std::uint32_t close(std::uint32_t token) const {
+        return link[token] & ~kOpen;
+    }
+
+    // the first token of the element or member behind the one at token
+    std::uint32_t next(std::uint32_t token) const {
+        std::uint32_t res = link[token];
+        return res & kOpen ? link[res & ~kOpen] : res;
+    }
+
+    // the text of the value at token, without the white space behind it
+    std::string_view text(std::uint32_t token) const {
+        std::size_t begin = pos[token];
+        if (isOpen(token)) {
+            return json.substr(begin, pos[close(token)] + 1 - begin);
+        }
+        std::size_t end = token + 1 < pos.size() ? pos[token + 1]
+                                                 : json.size();
+        while (end > begin && _ParserScan::isWhiteSpace(json[end - 1])) {
+            --end;
+        }
+        return json.substr(begin, end - begin);
+    }
+
+    [[noreturn]] void unexpected(std::uint32_t token) const {
+        throw std::invalid_argument(
+          std::format("\033[1;31munexpected character {} at {}\033[0m",
+            json.substr(pos[token], 1), pos[token]));
+    }
+
+    // a number only begins right, it is read by LazyValue::getNumber
+    void checkScalar(std::uint32_t token) const {
+        char ch = head(token);
+        if (ch == '-' || _ParserScan::isDigit(ch)) {
+            return;
+        }
+        std::string_view literal = ch == 't'   ? "true"
+                                   : ch == 'f' ? "false"
+                                   : ch == 'n' ? "null"
+                                               : "";
+        if (literal.empty() || text(token) != literal) {
+            unexpected(token);
+        }
+    }
+
+    /***
+     * @description: check that the tokens form one json value, each { [
+     * closed by the same kind, a key and : before each member value and
+     * , between them, and link the tokens on the way
+     * @exception: std::invalid_argument if they do not
+     ***/
+    void build(std::string_view json_str) {
+        if (json_str.size() > UINT32_MAX) {
+            throw std::invalid_argument(
+              "\033[1;31mtoo large for a lazy document\033[0m");
+        }
+        json = json_str;
+        _SimdScan::buildStructuralIndex(json, pos);
+        if (pos.empty()) {
+            // only white space, a null like the other parsers give
+            json = "null";
+            pos.push_back(0);
+        }
+        if (pos.size() >= kOpen) {
+            throw std::invalid_argument(
+              "\033[1;31mtoo many tokens for a lazy document\033[0m");
+        }
+        link.assign(pos.size(), 0);
+
+        enum class _Expect : std::uint8_t {
+            VALUE,
+            FIRST_VALUE, // a value or ]
+            KEY,
+            FIRST_KEY,   // a key or }
+            COLON,
+            NEXT,        // , or the close of the container
+            DONE,
+        };
+        _Expect expect = _Expect::VALUE;
+        // an open { or [ and the first token of its last element or member
+        struct _Open {
+            std::uint32_t token;
+            std::uint32_t element;
+        };
+        std::vector< _Open > open;
+        auto valueDone = [&]() {
+            expect = open.empty() ? _Expect::DONE : _Expect::NEXT;
+        };
+        // a value of a list is an element, the one of a dict is behind a key
+        auto element = [&](std::uint32_t token) {
+            if (!open.empty() && head(open.back().token) == '[') {
+                open.back().element = token;
+            }
+        };
+        auto linkNext = [&](std::uint32_t next) {
+            std::uint32_t from = open.back().element;
+            link[isOpen(from) ? close(from) : from] = next;
+        };
+
+        const auto count = static_cast< std::uint32_t >(pos.size());
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const char ch = head(i);
+            const bool value =
+              expect == _Expect::VALUE || expect == _Expect::FIRST_VALUE;
+            switch (ch) {
+                case '{':
+                case '[':
+                    if (!value) {
+                        unexpected(i);
+                    }
+                    element(i);
+                    open.push_back(_Open{i, i});
+                    expect =
+                      ch == '{' ? _Expect::FIRST_KEY : _Expect::FIRST_VALUE;
+                    break;
+                case '}':
+                case ']': {
+                    const char opener = ch == '}' ? '{' : '[';
+                    const _Expect first =
+                      ch == '}' ? _Expect::FIRST_KEY : _Expect::FIRST_VALUE;
+                    if ((expect != first && expect != _Expect::NEXT)
+                        || head(open.back().token) != opener)
+                    {
+                        unexpected(i);
+                    }
+                    if (expect == _Expect::NEXT) {
+                        linkNext(i);
+                    }
+                    link[open.back().token] = i | kOpen;
+                    open.pop_back();
+                    valueDone();
+                    break;
+                }
+                case ':':
+                    if (expect != _Expect::COLON) {
+                        unexpected(i);
+                    }
+                    expect = _Expect::VALUE;
+                    break;
+                case ',':
+                    if (expect != _Expect::NEXT) {
+                        unexpected(i);
+                    }
+                    linkNext(i + 1);
+                    expect = head(open.back().token) == '{' ? _Expect::KEY
+                                                            : _Expect::VALUE;
+                    break;
+                case '\"':
+                    if (expect == _Expect::KEY
+                        || expect == _Expect::FIRST_KEY)
+                    {
+                        open.back().element = i;
+                        expect              = _Expect::COLON;
+                    }
+                    else if (value) {
+                        element(i);
+                        valueDone();
+                    }
+                    else {
+                        unexpected(i);
+                    }
+                    break;
+                default:
+                    if (!value) {
+                        unexpected(i);
+                    }
+                    checkScalar(i);
+                    element(i);
+                    valueDone();
+                    break;
+            }
+        }
+        if (expect != _Expect::DONE) {
+            throw std::invalid_argument(
+              "\033[1;31mjson ends before the root value does\033[0m");
+        }
+        // a string still open at the end has no token behind it
+        if (head(count - 1) == '\"') {
+            std::size_t reads = pos[count - 1];
+            _ParserScan::scanString(json, reads);
+        }
+    }
+};
+
+template < bool Members >
+class _LazyIter;
+
+template < bool Members >
+struct _LazyRange;
+
+} // namespace __detail
+
+/***
+ * @description: a view of one value of a LazyDocument, valid as long as the
+ * document and its json string. Nothing of it is parsed until it is read,
+ * and the strings and numbers are checked then.
+ ***/
+class LazyValue {
+  private:
+    const __detail::_LazyIndex* m_index;
+    std::uint32_t m_token;
+
+    template < bool Members >
+    friend class __detail::_LazyIter;
+
+    char head() const { return m_index->head(m_token); }
+
+    void expect(char open, std::string_view what) const {
+        if (head() != open) {
+            throw std::runtime_error(
+              std::format("\033[1;31mNot a {}, can't use {}\033[0m",
+                open == '[' ? "ListType" : "DictType", what));
+        }
+    }
+
+    // the close of a list or dict, where its elements end
+    std::uint32_t end() const { return m_index->close(m_token); }
+
+    // the string at token, decoded into buffer if it has escape chars
+    std::string_view string(std::uint32_t token, std::string& buffer) const {
+        std::size_t reads = m_index->pos[token];
+        auto span = __detail::_ParserScan::scanString(m_index->json, reads);
+        if (!span.has_escape) {
+            return span.str;
+        }
+        buffer.clear();
+        __detail::_ParserScan::escapeString(span.str, buffer, span.offset);
+        return buffer;
+    }
+
+    std::string decoded(std::uint32_t token) const {
+        std::string buffer;
+        std::string_view str = string(token, buffer);
+        return str.data() == buffer.data() ? std::move(buffer)
+                                           : std::string{str};
+    }
+
+    // the token of the value of key, nullopt if there is none. A repeated
+    // key takes the last value, as in the tree
+    std::optional< std::uint32_t > findMember(std::string_view key) const {
+        expect('{', "[]");
+        std::string buffer;
+        std::optional< std::uint32_t > found;
+        for (std::uint32_t token = m_token + 1; token != end();) {
+            if (string(token, buffer) == key) {
+                found = token + 2;
+            }
+            token = m_index->next(token);
+        }
+        return found;
+    }
+
+  public:
+    LazyValue(const __detail::_LazyIndex* index, std::uint32_t token)
+        : m_index{index}, m_token{token} {}
+
+    bool isNull() const { return head() == 'n'; }
+
+    bool isBool() const { return head() == 't' || head() == 'f'; }
+
+    bool isNumber() const {
+        return head() == '-' || __detail::_ParserScan::isDigit(head());
+    }
+
+    bool isString() const { return head() == '\"'; }
+
+    bool isList() const { return head() == '['; }
+
+    bool isDict() const { return head() == '{'; }
+
+    // the json text of the value in the source, as it was written
+    std::string_view raw() const { return m_index->text(m_token); }
+
+    /**
+     * @brief: the value of true or false
+     * @exception: std::runtime_error if not a bool
+     */
+    bool getBool() const {
+        if (!isBool()) {
+            throw std::runtime_error(
+              "\033[1;31mNot a bool, can't use getBool\033[0m");
+        }
+        return head() == 't';
+    }
+
+    /**
+     * @brief: the decoded string
+     * @exception: std::runtime_error if not a string, std::invalid_argument
+     * if it is not valid json
+     */
+    std::string getString() const {
+        if (!isString()) {
+            throw std::runtime_error(
+              "\033[1;31mNot a string, can't use getString\033[0m");
+        }
+        return decoded(m_token);
+    }
+
+    /**
+     * @brief: the number as T, like TJsonObj::getNumber
+     * @exception: std::runtime_error if not a number, std::invalid_argument
+     * if it is not valid json
+     */
+    template < typename T >
+        requires std::is_arithmetic_v< T >
+    T getNumber() const {
+        namespace scan = __detail::_ParserScan;
+        if (!isNumber()) {
+            throw std::runtime_error(
+              "\033[1;31mNot a number, can't use getNumber\033[0m");
+        }
+        std::string_view text = raw();
+        std::size_t reads     = 0;
+        auto [str, is_integer] = scan::scanNumber(text, reads);
+        if (reads != text.size()) {
+            throw std::invalid_argument(std::format(
+              "\033[1;31minvalid json number {} at {}\033[0m", text,
+              m_index->pos[m_token]));
+        }
+        if (is_integer) {
+            if (auto value = scan::tryParse< std::int64_t >(str)) {
+                return static_cast< T >(value.value());
+            }
+            if (auto value = scan::tryParse< std::uint64_t >(str)) {
+                return static_cast< T >(value.value());
+            }
+        }
+        if (auto value = scan::tryParse< double >(str)) {
+            return static_cast< T >(value.value());
+        }
+        throw std::runtime_error(
+          std::format("\033[1;31m{} can't be converted\033[0m", str));
+    }
+
+    // the elements of a list or the members of a dict, 0 otherwise, they
+    // are counted each time
+    std::size_t size() const {
+        if (!isList() && !isDict()) {
+            return 0;
+        }
+        std::size_t count = 0;
+        for (std::uint32_t token = m_token + 1; token != end(); ++count) {
+            token = m_index->next(token);
+        }
+        return count;
+    }
+
+    /**
+     * @brief: the element at index, the ones before it are skipped
+     * @exception: std::runtime_error if not a list or out of range
+     */
+    LazyValue operator[](std::size_t index) const {
+        expect('[', "[]");
+        std::uint32_t token = m_token + 1;
+        for (; token != end() && index > 0; --index) {
+            token = m_index->next(token);
+        }
+        if (token == end()) {
+            throw std::runtime_error(
+              "\033[1;31mthe index is out of range\033[0m");
+        }
+        return {m_index, token};
+    }
+
+    /**
+     * @brief: the value of key, the members are searched in order and the
+     * values in between are skipped, a repeated key gives the last value
+     * @exception: std::runtime_error if not a dict or the key is not there
+     */
+    LazyValue operator[](std::string_view key) const {
+        if (auto token = findMember(key)) {
+            return {m_index, token.value()};
+        }
+        throw std::runtime_error("\033[1;31mkey not found\033[0m");
+    }
+
+    bool contains(std::string_view key) const {
+        return findMember(key).has_value();
+    }
+
+    // for (LazyValue element : value.items())
+    __detail::_LazyRange< false > items() const;
+
+    // for (auto [key, value] : value.members())
+    __detail::_LazyRange< true > members() const;
+
+    /**
+     * @brief: parse this value into a TJsonObj
+     * @param  resource {std::pmr::memory_resource*}: where the tree is
+     * allocated, nullptr means the default resource
+     * @exception: std::invalid_argument if it is not valid json
+     */
+    TJsonObj toObj(std::pmr::memory_resource* resource = nullptr) const {
+        __detail::_ParserScan::_ScanContext ctx{ParseOptions{}};
+        __detail::_DomHandler dom{
+          resource ? resource : std::pmr::get_default_resource()};
+        __detail::_ParserScan::scanDocument(raw(), ctx, dom);
+        return dom.take();
+    }
+};
+
+// a member of a dict in a lazy document, the key is decoded
+struct LazyMember {
+    std::string key;
+    LazyValue value;
+};
+
+namespace __detail {
+
+// walk the elements, or the keys of the members if Members is set
+template < bool Members >
+class _LazyIter {
+  private:
+    LazyValue m_at;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::conditional_t< Members, LazyMember, LazyValue >;
+    using difference_type = std::ptrdiff_t;
+
+    _LazyIter(LazyValue at) : m_at{at} {}
+
+    value_type operator*() const {
+        if constexpr (Members) {
+            return {m_at.decoded(m_at.m_token),
+              LazyValue{m_at.m_index, m_at.m_token + 2}};
+        }
+        else {
+            return m_at;
+        }
+    }
+
+    _LazyIter& operator++() {
+        m_at.m_token = m_at.m_index->next(m_at.m_token);
+        return *this;
+    }
+
+    _LazyIter operator++(int) {
+        _LazyIter res = *this;
+        ++*this;
+        return res;
+    }
+
+    bool operator==(const _LazyIter& other) const {
+        return m_at.m_token == other.m_at.m_token;
+    }
+};
+
+template < bool Members >
+struct _LazyRange {
+    _LazyIter< Members > first;
+    _LazyIter< Members > last;
+
+    _LazyIter< Members > begin() const { return first; }
+
+    _LazyIter< Members > end() const { return last; }
+};
+
+} // namespace __detail
+
+inline __detail::_LazyRange< false > LazyValue::items() const {
+    expect('[', "items");
+    return {LazyValue{m_index, m_token + 1}, LazyValue{m_index, end()}};
+}
+
+inline __detail::_LazyRange< true > LazyValue::members() const {
+    expect('{', "members");
+    return {LazyValue{m_index, m_token + 1}, LazyValue{m_index, end()}};
+}
+
+/***
+ * @description: a json document that keeps the json string and its token
+ * positions, instead of a tree. The structure is checked when it is made,
+ * the brackets matched in the same pass, and operator[] then skips every
+ * value it does not go into in one step. Use it to read a few values of a
+ * large document, a TJsonObj or TJsonTape is faster to read all of them.
+ * @example:
+ *   std::string json_str = readFile("big.json");
+ *   LazyDocument doc{json_str};
+ *   doc["records"][1000]["name"].getString();
+ ***/
+class LazyDocument {
+  private:
+    // on the heap so the values stay valid when the document is moved
+    std::unique_ptr< __detail::_LazyIndex > m_index;
+
+  public:
+    LazyDocument() : LazyDocument(std::string_view{}) {}
+
+    /***
+     * @param  json_str {std::string_view}: the json string, it is not
+     * copied and must outlive the document
+     * @exception: std::invalid_argument if the structure is not valid json,
+     * the strings and numbers are checked when read
+     ***/
+    explicit LazyDocument(std::string_view json_str)
+        : m_index{std::make_unique< __detail::_LazyIndex >()} {
+        m_index->build(json_str);
+    }
+
+    LazyValue root() const { return {m_index.get(), 0}; }
+
+    LazyValue operator[](std::string_view key) const { return root()[key]; }
+
+    LazyValue operator[](std::size_t index) const { return root()[index]; }
+
+    // the { } [ ] : , strings, numbers and literals of the document
+    std::size_t tokenCount() const { return m_index->pos.size(); }
+
+    // the bytes of the token positions, the json string is not counted
+    std::size_t memoryBytes() const {
+        return (m_index->pos.capacity() + m_index->link.capacity())
+             * sizeof(std::uint32_t);
+    }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_LAZY_HPP__
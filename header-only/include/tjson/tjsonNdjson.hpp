@@ -0,0 +1,236 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-24T14:20:36
+ * @lastmod: 2024-07-24T14:20:36
+ * @description: read newline-delimited json, the records are parsed by a
+ * pool of threads
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonNdjson.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_NDJSON_HPP__
+#define __TJSON_NDJSON_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <exception>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+// one line of the input, error is empty if it was parsed
+struct NdjsonRecord {
+    std::size_t line; // from 1
+    TJsonObj value;
+    std::string error;
+
+    bool ok() const { return error.empty(); }
+};
+
+class NdjsonReader {
+  private:
+    // lines given to one worker at a time
+    struct _Batch {
+        std::string_view text;
+        std::size_t first_line;
+        std::vector< NdjsonRecord > records;
+        bool done = false;
+    };
+
+    std::size_t m_threads;
+    ParseOptions m_options;
+    std::size_t m_batch_bytes = 1 << 20;
+
+    // split the input at the first new line behind every m_batch_bytes
+    std::vector< _Batch > split(std::string_view input) const {
+        std::vector< _Batch > batches;
+        std::size_t line = 1;
+        while (!input.empty()) {
+            std::size_t cut = input.size();
+            if (input.size() > m_batch_bytes) {
+                cut = input.find('\n', m_batch_bytes);
+                cut = cut == std::string_view::npos ? input.size() : cut + 1;
+            }
+            std::string_view text = input.substr(0, cut);
+            batches.push_back(_Batch{text, line});
+            line += std::count(text.begin(), text.end(), '\n');
+            input.remove_prefix(cut);
+        }
+        return batches;
+    }
+
+    // parse every line of the batch, a bad line only fails its own record
+    void parseBatch(_Batch& batch) const {
+        __detail::_ParserScan::_ScanContext ctx{m_options};
+        if (!ctx.opts.resource) {
+            ctx.opts.resource = std::pmr::get_default_resource();
+        }
+        // the records may outlive the input
+        ctx.opts.insitu = false;
+
+        std::string_view text = batch.text;
+        std::size_t line      = batch.first_line;
+        for (; !text.empty(); ++line) {
+            std::size_t end = text.find('\n');
+            if (end == std::string_view::npos) {
+                end = text.size();
+            }
+            std::string_view record = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+
+            // skip the blank lines, \r is white space
+            if (record.find_first_not_of(" \t\r")
+                == std::string_view::npos)
+            {
+                continue;
+            }
+            NdjsonRecord& res = batch.records.emplace_back(
+              NdjsonRecord{line, TJsonObj{}, {}});
+            try {
+                __detail::_DomHandler dom{ctx.opts.resource};
+                ctx.index.clear();
+                ctx.index_pos = 0;
+                __detail::_ParserScan::scanDocument(record, ctx, dom);
+                res.value = dom.take();
+            } catch (const std::exception& e) {
+                res.error = e.what();
+            }
+        }
+    }
+
+  public:
+    /***
+     * @param  threads {std::size_t}: how many threads parse the records,
+     * 0 means std::thread::hardware_concurrency()
+     * @param  options {ParseOptions}: how to parse each record, insitu and
+     * arena are ignored since the records outlive the input
+     ***/
+    explicit NdjsonReader(std::size_t threads = 0, ParseOptions options = {})
+        : m_threads{threads}, m_options{options} {
+        if (m_threads == 0) {
+            m_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_options.arena = false;
+    }
+
+    // how many bytes a worker takes at a time, cut at a new line
+    void setBatchBytes(std::size_t bytes) {
+        m_batch_bytes = std::max< std::size_t >(bytes, 1);
+    }
+
+    /***
+     * @param  input {std::string_view}: one json value per line, blank
+     * lines are skipped
+     * @param  callback {Callback}: called with each NdjsonRecord in the
+     * order of the lines, always on the calling thread
+     * @description: the workers parse the batches ahead of the callback,
+     * at most two batches per thread are kept waiting for it. If the
+     * callback throws, the workers are stopped and the exception is
+     * rethrown.
+     ***/
+    template < std::invocable< NdjsonRecord&& > Callback >
+    void read(std::string_view input, Callback&& callback) const {
+        std::vector< _Batch > batches = split(input);
+        const std::size_t window      = m_threads * 2;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic< std::size_t > next{0};
+        std::size_t delivered = 0; // guarded by mutex
+        bool stop             = false;
+
+        auto work = [&]() {
+            while (true) {
+                std::size_t i = next.fetch_add(1);
+                if (i >= batches.size()) {
+                    return;
+                }
+                {
+                    // don't run too far ahead of the callback
+                    std::unique_lock lock{mutex};
+                    cv.wait(lock,
+                      [&]() { return stop || i < delivered + window; });
+                    if (stop) {
+                        return;
+                    }
+                }
+                parseBatch(batches[i]);
+                std::lock_guard lock{mutex};
+                batches[i].done = true;
+                cv.notify_all();
+            }
+        };
+
+        std::vector< std::thread > workers;
+        if (m_threads > 1 && batches.size() > 1) {
+            std::size_t count = std::min(m_threads, batches.size());
+            workers.reserve(count);
+            for (std::size_t t = 0; t < count; ++t) {
+                workers.emplace_back(work);
+            }
+        }
+
+        std::exception_ptr error;
+        try {
+            for (std::size_t i = 0; i < batches.size(); ++i) {
+                if (workers.empty()) {
+                    parseBatch(batches[i]);
+                }
+                else {
+                    std::unique_lock lock{mutex};
+                    cv.wait(lock, [&]() { return batches[i].done; });
+                }
+                for (auto& record : batches[i].records) {
+                    callback(std::move(record));
+                }
+                // free the batch before waiting for the next one
+                std::vector< NdjsonRecord >{}.swap(batches[i].records);
+                std::lock_guard lock{mutex};
+                delivered = i + 1;
+                cv.notify_all();
+            }
+        } catch (...) {
+            error = std::current_exception();
+            std::lock_guard lock{mutex};
+            stop = true;
+            cv.notify_all();
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // all the records in the order of the lines
+    std::vector< NdjsonRecord > read(std::string_view input) const {
+        std::vector< NdjsonRecord > records;
+        read(input, [&records](NdjsonRecord&& record) {
+            records.push_back(std::move(record));
+        });
+        return records;
+    }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_NDJSON_HPP__
@@ -12,84 +12,110 @@
 #define __TJSON_OBJ_HPP__
 
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <format>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "tjson/detail/_OrderedDict.hpp"
+#include "tjson/detail/_ParallelDump.hpp"
+#include "tjson/detail/_Serializer.hpp"
+#include "tjson/tjsonOptions.hpp"
+#include "tjson/tjsonPointer.hpp"
+
 namespace lap {
 
 namespace tjson {
 
+namespace __detail {
+// hash std::string_view, const char* and pmr string the same way, so
+// DictType can be searched without building a key
+struct _StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view str) const noexcept {
+        return std::hash< std::string_view >{}(str);
+    }
+};
+} // namespace __detail
+
+// a json number kept as the text in source, converted when accessed
+struct RawNumber {
+    std::pmr::string str;
+
+    bool operator==(const RawNumber&) const = default;
+};
+
+// a key hashed once, to look up the same key in many objects, str must
+// outlive it
+struct HashedKey {
+    std::string_view str;
+    std::size_t hash;
+
+    explicit HashedKey(std::string_view key)
+        : str{key}, hash{__detail::_StringHash{}(key)} {}
+};
+
 class TJsonObj {
     friend std::ostream& operator<<(std::ostream& os, const TJsonObj& obj) {
-        obj.print();
-        return os;
+        return os << obj.toString();
     }
 
   public:
-    using ListType   = std::vector< TJsonObj >;
-    using DictType   = std::unordered_map< std::string, TJsonObj >;
+    // all the storage can be given a std::pmr::memory_resource, the parser
+    // uses it to allocate a whole tree from one arena. These were std::string,
+    // std::vector and std::unordered_map before 0.2, name them by the aliases
+    // (see "upgrading from 0.1" in the README)
+    using StringType = std::pmr::string;
+    using ListType   = std::pmr::vector< TJsonObj >;
+#ifdef TJSON_UNORDERED_DICT
+    using DictType = std::pmr::unordered_map< StringType, TJsonObj,
+      __detail::_StringHash, std::equal_to<> >;
+#else
+    // the members in insertion order, see _OrderedDict
+    using DictType = __detail::_OrderedDict< TJsonObj >;
+#endif
     using value_type = std::variant< std::monostate, // null
-      std::string,                                   // "String"
+      StringType,                                    // "String"
       ListType,                                      // [1,2, "ss", {}]
       DictType, // {"key":{"value":"Hello"}}
-      double,   // 1.0
-      int,      // 1 2 10
-      bool      // true or false
+      double,        // 1.0
+      int,           // 1 2 10
+      bool,          // true or false
+      std::int64_t,  // -4294967296
+      std::uint64_t, // 18446744073709551615
+      RawNumber,     // 9007199254740993 kept as text
+      std::string_view // "String" borrowed from the source buffer
       >;
 
   private:
     value_type m_value;
 
-  protected:
-    template < typename Callable >
-    void call(const Callable& op) const {
-        auto DoInvoke = [&](const auto&... args) { std::invoke(op, args...); };
-        std::visit(
-          [&](const auto& arg) {
-              using T = std::decay_t< decltype(arg) >;
-              if constexpr (std::is_same_v< T, std::monostate >) {
-                  DoInvoke("null");
-              }
-              else if constexpr (std::is_same_v< T, std::string >) {
-                  DoInvoke(std::format("\"{}\"", arg));
-              }
-              else if constexpr (std::is_same_v< T, double >) {
-                  DoInvoke(arg);
-              }
-              else if constexpr (std::is_same_v< T, int >) {
-                  DoInvoke(std::to_string(arg));
-              }
-              else if constexpr (std::is_same_v< T, bool >) {
-                  DoInvoke(arg ? "true" : "false");
-              }
-              else if constexpr (std::is_same_v< T, ListType >) {
-                  DoInvoke("[");
-                  for (size_t i = 0; i < arg.size(); ++i) {
-                      arg[i].call(op);
-                      if (i + 1 < arg.size()) DoInvoke(", ");
-                  }
-                  DoInvoke("]");
-              }
-              else if constexpr (std::is_same_v< T, DictType >) {
-                  DoInvoke("{");
-                  for (auto it = arg.cbegin(); it != arg.cend(); ++it) {
-                      DoInvoke(std::format("\"{}\": ", it->first));
-                      it->second.call(op);
-                      if (std::next(it) != arg.cend()) DoInvoke(", ");
-                  }
-                  DoInvoke("}");
-              }
-          },
-          m_value);
+    // std::string and std::string_view are stored as StringType
+    template < typename T >
+    static value_type toValue(T&& t) {
+        using U = std::decay_t< T >;
+        if constexpr (std::is_convertible_v< const U&, std::string_view > &&
+                      !std::is_same_v< U, StringType >)
+        {
+            return value_type{
+              std::in_place_type< StringType >, std::string_view{t}};
+        }
+        else {
+            return value_type{std::forward< T >(t)};
+        }
     }
 
   public:
@@ -97,22 +123,96 @@ class TJsonObj {
 
     const value_type& get() const { return m_value; }
 
+    value_type& get() { return m_value; }
+
+    // an rvalue string, list or dict is moved in, never copied
     template < typename T >
-    TJsonObj(T t) : m_value(std::move(t)) {}
+        requires(!std::is_same_v< std::remove_cvref_t< T >, TJsonObj >)
+    TJsonObj(T&& t) : m_value(toValue(std::forward< T >(t))) {}
+
+    // construct the alternative T in place, e.g. a borrowed std::string_view
+    template < typename T, typename... Args >
+    explicit TJsonObj(std::in_place_type_t< T > tag, Args&&... args)
+        : m_value(tag, std::forward< Args >(args)...) {}
+
+    // declared so that moving keeps the memory resource of the containers,
+    // a copy always goes to the default resource
+    TJsonObj(const TJsonObj&)                = default;
+    TJsonObj(TJsonObj&&) noexcept            = default;
+    TJsonObj& operator=(const TJsonObj&)     = default;
+    TJsonObj& operator=(TJsonObj&&) noexcept = default;
 
     ~TJsonObj() = default;
 
-    void println() const {
-        this->print();
-        std::cout << std::endl;
+    bool isString() const {
+        return std::holds_alternative< StringType >(m_value) ||
+               std::holds_alternative< std::string_view >(m_value);
+    }
+
+    /**
+     * @brief: get an owned or borrowed string
+     * @exception: std::runtime_error if not a string
+     */
+    std::string_view getString() const {
+        if (auto str = std::get_if< StringType >(&m_value)) {
+            return *str;
+        }
+        if (auto str = std::get_if< std::string_view >(&m_value)) {
+            return *str;
+        }
+        throw std::runtime_error(
+          "\033[1;31mNot a string, can't use getString\033[0m");
+    }
+
+    /**
+     * @brief: get any kind of number as T, RawNumber is converted here
+     * @exception: std::runtime_error if not a number or can't be converted
+     */
+    template < typename T >
+        requires std::is_arithmetic_v< T >
+    T getNumber() const {
+        return std::visit(
+          [](const auto& arg) -> T {
+              using U = std::decay_t< decltype(arg) >;
+              if constexpr (std::is_same_v< U, RawNumber >) {
+                  T value{};
+                  auto end = arg.str.data() + arg.str.size();
+                  auto res = std::from_chars(arg.str.data(), end, value);
+                  if (res.ec == std::errc() && res.ptr == end) {
+                      return value;
+                  }
+                  throw std::runtime_error(std::format(
+                    "\033[1;31m{} can't be converted\033[0m", arg.str));
+              }
+              else if constexpr (std::is_arithmetic_v< U > &&
+                                 !std::is_same_v< U, bool >)
+              {
+                  return static_cast< T >(arg);
+              }
+              else {
+                  throw std::runtime_error(
+                    "\033[1;31mNot a number, can't use getNumber\033[0m");
+              }
+          },
+          m_value);
+    }
+
+    /**
+     * @brief: the json text is built in one buffer and written to
+     * std::cout at once
+     */
+    void print(const FormatOptions& options = {}) const {
+        std::string out = toString(options);
+        std::cout.write(out.data(), out.size());
     }
 
-    void print() const {
-        call([](const auto&... arg) { ((std::cout << arg), ...); });
+    void println(const FormatOptions& options = {}) const {
+        std::string out = toString(options);
+        out.push_back('\n');
+        std::cout.write(out.data(), out.size()).flush();
     }
 
     std::pair< DictType, std::string > toMap() const {
-        std::ostringstream oss;
         DictType objMap;
         if (std::holds_alternative< DictType >(m_value)) {
             for (const auto& [key, value] : std::get< DictType >(m_value)) {
@@ -123,9 +223,7 @@ class TJsonObj {
             throw std::runtime_error(
               "\033[1;31mNot a DictType, maybe { or } is missing\033[0m");
         }
-        call([&oss](
-               const auto&... arg) { ((oss << std::format("{}", arg)), ...); });
-        return {objMap, oss.str()};
+        return {objMap, toString()};
     }
 
     // @note: since the TJsonObj<T>(T t) has implemented , this is deprecated
@@ -135,16 +233,53 @@ class TJsonObj {
     // }
 
     template < typename T >
-    auto operator=(T t) -> TJsonObj& {
-        set(t);
+        requires(!std::is_same_v< std::remove_cvref_t< T >, TJsonObj >)
+    auto operator=(T&& t) -> TJsonObj& {
+        set(std::forward< T >(t));
         return *this;
     }
 
-    template < typename T,
-      typename = std::enable_if_t< !std::is_same_v< T, TJsonObj > > >
-    // requires(!std::is_same_v< T, TJsonObj >)
-    void set(const T& src) {
-        m_value = src;
+    // like operator=, an lvalue is copied and an rvalue moved
+    template < typename T >
+        requires(!std::is_same_v< std::remove_cvref_t< T >, TJsonObj >)
+    void set(T&& src) {
+        m_value = toValue(std::forward< T >(src));
+    }
+
+    /**
+     * @brief: append an element made of args to a list, like
+     * TJsonObj(args...), an rvalue is moved in
+     * @return: the new element
+     * @exception: std::runtime_error if not a list
+     */
+    template < typename... Args >
+    TJsonObj& emplace_back(Args&&... args) {
+        if (auto* list = std::get_if< ListType >(&m_value)) {
+            return list->emplace_back(std::forward< Args >(args)...);
+        }
+        throw std::runtime_error(
+          "\033[1;31mNot a ListType, can't use emplace_back\033[0m");
+    }
+
+    /**
+     * @brief: add the member key made of args to a dict, nothing is made if
+     * the key is there
+     * @return: the member and whether it is new
+     * @exception: std::runtime_error if not a dict
+     */
+    template < typename... Args >
+    std::pair< DictType::iterator, bool > try_emplace(
+      std::string_view key, Args&&... args) {
+        if (auto* dict = std::get_if< DictType >(&m_value)) {
+#ifdef TJSON_UNORDERED_DICT
+            return dict->try_emplace(
+              StringType{key}, std::forward< Args >(args)...);
+#else
+            return dict->try_emplace(key, std::forward< Args >(args)...);
+#endif
+        }
+        throw std::runtime_error(
+          "\033[1;31mNot a DictType, can't use try_emplace\033[0m");
     }
 
     auto operator[](size_t index) -> TJsonObj& {
@@ -155,26 +290,89 @@ class TJsonObj {
           "\033[1;31mNot a ListType, can't use []\033[0m");
     }
 
-    auto operator[](const std::string& key) -> TJsonObj& {
+    auto operator[](const std::string_view key) -> TJsonObj& {
         if (std::holds_alternative< DictType >(m_value)) {
-            return std::get< DictType >(m_value)[key];
+            auto& dict = std::get< DictType >(m_value);
+            if (auto iter = dict.find(key); iter != dict.end()) {
+                return iter->second;
+            }
+            return dict.try_emplace(StringType{key}).first->second;
         }
         throw std::runtime_error(
           "\033[1;31mNot a DictType, can't use []\033[0m");
     }
 
+    // like operator[](std::string_view), the key is not hashed again
+    auto operator[](const HashedKey& key) -> TJsonObj& {
+        if (auto* dict = std::get_if< DictType >(&m_value)) {
+#ifdef TJSON_UNORDERED_DICT
+            auto iter = dict->find(key.str);
+#else
+            auto iter = dict->find(key.str, key.hash);
+#endif
+            if (iter != dict->end()) {
+                return iter->second;
+            }
+            return dict->try_emplace(StringType{key.str}).first->second;
+        }
+        throw std::runtime_error(
+          "\033[1;31mNot a DictType, can't use []\033[0m");
+    }
+
+    /**
+     * @brief: the value at a JSON Pointer, like "/list/5/lop", "" is this
+     * one. Parse it once with JsonPointer to look it up in many values
+     * @exception: std::invalid_argument if pointer does not start with /,
+     * std::runtime_error if there is no value at it
+     */
+    const TJsonObj& at(std::string_view pointer) const {
+        return JsonPointer{pointer}.at(*this);
+    }
+
+    TJsonObj& at(std::string_view pointer) {
+        return JsonPointer{pointer}.at(*this);
+    }
+
+    const TJsonObj& at(const JsonPointer& pointer) const {
+        return pointer.at(*this);
+    }
+
+    TJsonObj& at(const JsonPointer& pointer) { return pointer.at(*this); }
+
+    // an owned and a borrowed string are equal if the chars are
     bool operator==(const TJsonObj& obj) const {
+        if (isString() && obj.isString()) {
+            return getString() == obj.getString();
+        }
         return m_value == obj.m_value;
     }
 
-    bool operator!=(const TJsonObj& obj) const {
-        return m_value != obj.m_value;
+    bool operator!=(const TJsonObj& obj) const { return !(*this == obj); }
+
+    /**
+     * @brief: the json text, built in one buffer, strings are escaped and
+     * doubles are written in the shortest form that reads back the same
+     * @param options {FormatOptions}: the layout, one line by default
+     */
+    std::string toString(const FormatOptions& options = {}) const {
+        std::string res;
+        dumpTo(res, options);
+        return res;
+    }
+
+    // append the json text to a std::string or any sink with append(const
+    // char*, size_t) and push_back(char)
+    template < __detail::_Serializer::CharSink Sink >
+    void dumpTo(Sink& sink, const FormatOptions& options = {}) const {
+        __detail::_ParallelDump::writeValue(sink, *this, options);
     }
 
-    std::string toString() const {
-        std::stringstream oss;
-        call([&oss](const auto&... arg) { ((oss << arg), ...); });
-        return oss.str();
+    // write the json text through an output iterator, return its end
+    template < std::output_iterator< char > Iter >
+    Iter dumpTo(Iter iter, const FormatOptions& options = {}) const {
+        __detail::_Serializer::_IteratorSink< Iter > sink{iter};
+        __detail::_ParallelDump::writeValue(sink, *this, options);
+        return sink.base();
     }
 
     void clear() { m_value = std::monostate{}; }
@@ -0,0 +1,83 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-20T14:02:17
+ * @lastmod: 2024-07-20T14:02:17
+ * @description: the options to control how the json string is parsed and
+ * written
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonOptions.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_OPTIONS_HPP__
+#define __TJSON_OPTIONS_HPP__
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace lap {
+
+namespace tjson {
+
+struct ParseOptions {
+    // keep numbers as RawNumber, the text is only converted when accessed
+    // by TJsonObj::getNumber, and is dumped back unchanged
+    bool raw_number = false;
+
+    // allocate the whole tree from a monotonic arena owned by the Parser,
+    // the tree lives as long as the Parser. It is still destroyed node by
+    // node, the arena saves the free of each node
+    bool arena = false;
+
+    // allocate the tree from this resource instead, nullptr means the
+    // default resource, it must outlive the tree
+    std::pmr::memory_resource* resource = nullptr;
+
+    // strings with no escape char are std::string_view into the buffer
+    // given to Parser::setView, which must outlive the tree and its copies,
+    // keys are still owned by DictType
+    bool insitu = false;
+
+    // parse in two stages, first find every token with simd (AVX2 or SSE2
+    // picked at runtime), then build the tree by walking those positions
+    // instead of the bytes. Building the tree dominates, so it parses at
+    // about the speed of the default path, see the README
+    bool structural_index = false;
+
+    // TJsonTape only, the keys of the same text are stored once and
+    // compared by their offset, see TJsonTape::key. The tree of a Parser
+    // keeps a StringType for each key
+    bool intern_keys = false;
+
+    // Parser and TJson only, parse the elements of a root list or object
+    // of some MB on this many threads, 0 means one per core. It has no
+    // effect with arena, and a resource must be safe to share by threads
+    std::size_t threads = 1;
+};
+
+// how TJsonObj::toString and print lay out the json text
+struct FormatOptions {
+    // spaces to indent each level with, one element per line, 0 puts the
+    // whole value on one line
+    std::size_t indent = 0;
+
+    // no space behind , and :, the indent is ignored
+    bool compact = false;
+
+    // the keys of each object in order, else in the order of the map
+    bool sort_keys = false;
+
+    // escape every non-ASCII char as \uXXXX, a surrogate pair above U+FFFF
+    bool ascii_only = false;
+
+    // render the parts of a large tree on this many threads and join them
+    // in order, 0 means one per core. A tree of fewer than 64K values is
+    // always written on one thread
+    std::size_t threads = 1;
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_OPTIONS_HPP__
@@ -10,13 +10,16 @@
 #ifndef __TJSON_PARSER_HPP__
 #define __TJSON_PARSER_HPP__
 
-#include <format>
+#include <memory>
+#include <memory_resource>
 #include <string_view>
-#include <variant>
+#include <thread>
 
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_ParallelParse.hpp"
 #include "tjson/detail/_ParserScan.hpp"
-#include "tjson/detail/_TJsonToken.hpp"
 #include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
 
 namespace lap {
 
@@ -28,124 +31,140 @@ class Parser {
   private:
     TJsonObj m_json_obj;
     std::string m_origin_str;
+    // what to parse, m_origin_str or the caller's buffer
+    std::string_view m_json_view;
+    ParseOptions m_options;
+
+    // the tree is allocated here if m_options.arena is set
+    std::unique_ptr< std::pmr::monotonic_buffer_resource > m_arena;
+
+    /***
+     * @description: drop the tree, its nodes are destroyed one by one even
+     * in arena mode, since a value set later may be on the heap. In the
+     * arena that walk frees nothing, its memory is released at once after.
+     ***/
+    void releaseTree() {
+        m_json_obj.clear();
+        if (m_arena) {
+            m_arena->release();
+        }
+    }
 
-    static TJsonObj scanImpl(std::string& json_str,
-      __detail::_TJsonToken::Type& state,
-      std::size_t&
-        reads) { /***
-                  * @param  reads {std::size_t}: how mach you have read
-                  * @param  state {__detail::_TJsonTokenType}: use as a state
-                  *machine
-                  * @return sttd::pair {*}: the json object and the reads
-                  * @exception: std::invalid_argument if the string can't be
-                  *parsed
-                  * @description: scan the json string and return the json
-                  *object
-                  ***/
+    // parse m_json_view into m_json_obj, without copying the result out
+    void parse() {
         using namespace __detail::_ParserScan;
-        if (json_str.empty()) {
-            return TJsonObj{std::monostate{}};
+        releaseTree();
+        _ScanContext ctx{m_options};
+        // only borrow from a buffer the caller keeps alive
+        ctx.opts.insitu =
+          ctx.opts.insitu && m_json_view.data() != m_origin_str.data();
+        if (ctx.opts.arena) {
+            if (!m_arena) {
+                m_arena =
+                  std::make_unique< std::pmr::monotonic_buffer_resource >();
+            }
+            ctx.opts.resource = m_arena.get();
+        }
+        else if (!ctx.opts.resource) {
+            ctx.opts.resource = std::pmr::get_default_resource();
         }
 
-        switch (state) {
-            case __detail::_TJsonToken::VALUE_SEPRATOR: {
-                update_state(json_str, state, reads, 1);
-                return scanImpl(json_str, state, reads);
-            }
-            case __detail::_TJsonToken::NAME_SEPRATOR: {
-            }
-            case __detail::_TJsonToken::BEGIN_OBJECT: {
-                return dealObjBegin(json_str, state, reads, scanImpl);
-            }
-            case __detail::_TJsonToken::VALUE_NUMBER: {
-                return dealValueNumber(json_str, state, reads);
-            }
-            case __detail::_TJsonToken::VALUE_STRING: {
-                return dealValueString(json_str, state, reads);
-            }
-            case __detail::_TJsonToken::LITERAL_TRUE: {
-                if (json_str.substr(0, 4) == "true") {
-                    json_str = json_str.substr(4);
-                    return TJsonObj{true};
-                }
-                else {
-                    throw std::invalid_argument(std::format(
-                      "\033[1;31mjson boolean {} ,maybe you mean true\033[0m",
-                      json_str.substr(0, 4)));
-                }
-                break;
-            }
-            case __detail::_TJsonToken::LITERAL_FALSE: {
-                if (json_str.substr(0, 5) == "false") {
-                    json_str = json_str.substr(5);
-                    return TJsonObj{false};
-                }
-                else {
-                    throw std::invalid_argument(
-                      std::format("\033[1;31mjson boolean {} ,maybe you mean "
-                                  "false\033[0m",
-                        json_str.substr(0, 5)));
-                }
-                break;
-            }
-            case __detail::_TJsonToken::LITERAL_NULL: {
-                if (json_str.substr(0, 4) == "null") {
-                    json_str = json_str.substr(4);
-                    return TJsonObj{std::monostate{}};
-                }
-                else {
-                    throw std::invalid_argument(
-                      std::format("\033[1;31mjson NULL {} ,maybe you mean "
-                                  "null\033[0m",
-                        json_str.substr(0, 4)));
-                }
-                break;
-            }
-            case __detail::_TJsonToken::LIST_BEGIN: {
-                return deaList(json_str, state, reads, scanImpl);
+        // the parts of a large root are parsed on threads, an arena is not
+        // safe to share between them
+        if (!ctx.opts.arena && ctx.opts.threads != 1) {
+            std::size_t threads = ctx.opts.threads
+                                  ? ctx.opts.threads
+                                  : std::thread::hardware_concurrency();
+            using __detail::_ParallelParse::parseRoot;
+            if (auto root = parseRoot(m_json_view, ctx.opts, threads)) {
+                m_json_obj = std::move(*root);
+                return;
             }
-            default:
-                break;
         }
-        return TJsonObj{};
+
+        // the tree is one handler of the sax events
+        __detail::_DomHandler dom{
+          ctx.opts.resource, m_json_view, ctx.opts.insitu};
+        scanDocument(m_json_view, ctx, dom);
+        m_json_obj = dom.take();
     }
 
   public:
-    Parser()  = default;
-    ~Parser() = default;
+    Parser() = default;
+
+    ~Parser() { releaseTree(); }
+
+    Parser(Parser&& other) noexcept { *this = std::move(other); }
+
+    Parser& operator=(Parser&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        // a short m_origin_str does not keep its address when moved
+        bool owned = other.m_json_view.data() == other.m_origin_str.data();
+        // drop the tree before its arena goes, then move-construct: a pmr
+        // move-assign between two resources copies the nodes into ours,
+        // the tree has to stay in the arena taken from other
+        releaseTree();
+        std::destroy_at(&m_json_obj);
+        std::construct_at(&m_json_obj, std::move(other.m_json_obj));
+        std::destroy_at(&other.m_json_obj);
+        std::construct_at(&other.m_json_obj);
+        m_origin_str = std::move(other.m_origin_str);
+        m_json_view  = owned ? m_origin_str : other.m_json_view;
+        m_options    = other.m_options;
+        m_arena      = std::move(other.m_arena);
+        return *this;
+    }
 
-    Parser(std::string json_str)
-        : m_origin_str{__detail::_ParserScan::escapeString(json_str)} {
-        this->operator()();
+    Parser(std::string json_str, ParseOptions options = {})
+        : m_origin_str{std::move(json_str)}, m_json_view{m_origin_str},
+          m_options{options} {
+        parse();
     }
 
+    void setOptions(ParseOptions options) { m_options = options; }
+
     void set(std::string json_str) {
-        m_origin_str = __detail::_ParserScan::escapeString(json_str);
-        this->operator()();
+        m_origin_str = std::move(json_str);
+        m_json_view  = m_origin_str;
+        parse();
+    }
+
+    /**
+     * @brief: parse the caller's buffer without copying it, it must be kept
+     * alive as long as the tree if ParseOptions::insitu is set
+     */
+    void setView(std::string_view json_str) {
+        m_origin_str.clear();
+        m_json_view = json_str;
+        parse();
     }
 
     TJsonObj operator()() {
-        std::string json_str = m_origin_str;
-        std::size_t reads = __detail::_ParserScan::jumpWhiteSpace(json_str, 0);
-        __detail::_TJsonToken::Type state =
-          __detail::_ParserScan::scanChar(json_str[reads]);
-        json_str   = json_str.substr(reads);
-        m_json_obj = scanImpl(json_str, state, reads);
+        parse();
         return m_json_obj;
     }
 
     TJsonObj operator()(std::string_view json_str) {
-        m_json_obj.set(
-          __detail::_ParserScan::escapeString(std::string(json_str)));
+        m_origin_str = json_str;
+        m_json_view  = m_origin_str;
         return this->operator()();
     }
 
     TJsonObj scan() { return this->operator()(); }
 
     void clear() {
-        m_json_obj.clear();
+        releaseTree();
         m_origin_str.clear();
+        m_json_view = {};
     }
+
+    /**
+     * @brief: the parsed tree, in arena mode it is only valid while the
+     * Parser is alive and not parsing again
+     */
+    const TJsonObj& get() const { return m_json_obj; }
 };
 
 } // namespace tjson
@@ -0,0 +1,200 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-08-01T15:21:08
+ * @lastmod: 2024-08-01T15:21:08
+ * @description: JSON Pointer (RFC 6901), parsed once and resolved in many
+ * documents
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonPointer.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_POINTER_HPP__
+#define __TJSON_POINTER_HPP__
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace lap {
+
+namespace tjson {
+
+/***
+ * @description: the tokens of a pointer like "/list/5/lop" are unescaped
+ * (~1 is / and ~0 is ~), hashed, and read as a list index once, so each
+ * step of resolve is one lookup in an object or list. "" is the whole
+ * document. The Obj of resolve is a TJsonObj, a template so that this
+ * header does not need it.
+ * @example:
+ *   JsonPointer x{"/nested/x"};
+ *   for (auto& record : records) {
+ *       if (auto* value = x.resolve(record.value)) { ... }
+ *   }
+ ***/
+class JsonPointer {
+  private:
+    struct _Token {
+        std::string key;
+        std::size_t hash;
+        // npos if key is not a list index
+        std::size_t index;
+    };
+
+    static constexpr std::size_t npos = static_cast< std::size_t >(-1);
+
+    std::string m_str;
+    std::vector< _Token > m_tokens;
+
+    // digits without a leading 0, as RFC 6901 says
+    static std::size_t toIndex(std::string_view key) {
+        std::size_t index = 0;
+        auto last         = key.data() + key.size();
+        auto res          = std::from_chars(key.data(), last, index);
+        if (key.empty() || res.ec != std::errc() || res.ptr != last
+            || (key.size() > 1 && key.front() == '0'))
+        {
+            return npos;
+        }
+        return index;
+    }
+
+    template < typename Dict >
+    static auto findMember(const Dict& dict, const _Token& token) {
+        if constexpr (requires { dict.find(token.key, token.hash); }) {
+            return dict.find(token.key, token.hash);
+        }
+        else {
+            return dict.find(std::string_view{token.key});
+        }
+    }
+
+    // follow the tokens from first on
+    template < typename Obj >
+    const Obj* walk(const Obj* node, std::size_t first) const {
+        using Dict = typename Obj::DictType;
+        using List = typename Obj::ListType;
+        for (std::size_t i = first; i < m_tokens.size(); ++i) {
+            const _Token& token = m_tokens[i];
+            if (auto* dict = std::get_if< Dict >(&node->get())) {
+                auto iter = findMember(*dict, token);
+                if (iter == dict->end()) {
+                    return nullptr;
+                }
+                node = &iter->second;
+            }
+            else if (auto* list = std::get_if< List >(&node->get())) {
+                if (token.index >= list->size()) {
+                    return nullptr;
+                }
+                node = &(*list)[token.index];
+            }
+            else {
+                return nullptr;
+            }
+        }
+        return node;
+    }
+
+    [[noreturn]] void notFound() const {
+        throw std::runtime_error(
+          std::format("\033[1;31m{} is not found\033[0m", m_str));
+    }
+
+  public:
+    JsonPointer() = default;
+
+    /**
+     * @param  pointer {std::string_view}: "" or tokens each behind a /
+     * @exception: std::invalid_argument if it is not empty and does not
+     * start with /
+     */
+    explicit JsonPointer(std::string_view pointer) : m_str{pointer} {
+        if (!pointer.empty() && pointer.front() != '/') {
+            throw std::invalid_argument(
+              "\033[1;31ma JSON Pointer starts with /\033[0m");
+        }
+        while (!pointer.empty()) {
+            pointer.remove_prefix(1);
+            std::size_t end = std::min(pointer.find('/'), pointer.size());
+            std::string key;
+            for (std::size_t i = 0; i < end; ++i) {
+                if (pointer[i] == '~' && i + 1 < end
+                    && (pointer[i + 1] == '0' || pointer[i + 1] == '1'))
+                {
+                    key.push_back(pointer[++i] == '0' ? '~' : '/');
+                }
+                else {
+                    key.push_back(pointer[i]);
+                }
+            }
+            pointer.remove_prefix(end);
+            std::size_t hash  = std::hash< std::string_view >{}(key);
+            std::size_t index = toIndex(key);
+            m_tokens.push_back(_Token{std::move(key), hash, index});
+        }
+    }
+
+    // the text it was made of
+    std::string_view str() const { return m_str; }
+
+    std::size_t size() const { return m_tokens.size(); }
+
+    // the value in root, nullptr if there is none
+    template < typename Obj >
+    const Obj* resolve(const Obj& root) const {
+        return walk(&root, 0);
+    }
+
+    template < typename Obj >
+    Obj* resolve(Obj& root) const {
+        return const_cast< Obj* >(walk(&root, 0));
+    }
+
+    // the first token is a member of dict, for the members of a TJson
+    template < typename Dict >
+    auto resolveMember(const Dict& dict) const ->
+      const typename Dict::mapped_type* {
+        if (m_tokens.empty()) {
+            return nullptr;
+        }
+        auto iter = findMember(dict, m_tokens.front());
+        if (iter == dict.end()) {
+            return nullptr;
+        }
+        return walk(&iter->second, 1);
+    }
+
+    /**
+     * @brief: the value in root
+     * @exception: std::runtime_error if there is none
+     */
+    template < typename Obj >
+    const Obj& at(const Obj& root) const {
+        if (const Obj* value = resolve(root)) {
+            return *value;
+        }
+        notFound();
+    }
+
+    template < typename Obj >
+    Obj& at(Obj& root) const {
+        if (Obj* value = resolve(root)) {
+            return *value;
+        }
+        notFound();
+    }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_POINTER_HPP__
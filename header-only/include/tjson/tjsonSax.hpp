@@ -0,0 +1,95 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-22T10:05:41
+ * @lastmod: 2024-07-22T10:05:41
+ * @description: parse a json string into events instead of a tree
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonSax.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_SAX_HPP__
+#define __TJSON_SAX_HPP__
+
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+/***
+ * @description: inherit it to only override the events you need, the
+ * string_view given to onKey, onString and onRawNumber is only valid during
+ * the call, copy it to keep it
+ ***/
+struct SaxHandlerBase {
+    void onStartObject() {}
+
+    void onKey(std::string_view) {}
+
+    void onEndObject() {}
+
+    void onStartList() {}
+
+    void onEndList() {}
+
+    void onString(std::string_view) {}
+
+    // integers that don't fit std::int64_t come as std::uint64_t, then as
+    // double if they still don't fit
+    void onInt64(std::int64_t) {}
+
+    void onUint64(std::uint64_t) {}
+
+    void onDouble(double) {}
+
+    // only with ParseOptions::raw_number, instead of the three above
+    void onRawNumber(std::string_view) {}
+
+    void onBool(bool) {}
+
+    void onNull() {}
+};
+
+template < typename Handler >
+concept SaxHandler = requires(Handler& handler, std::string_view str) {
+    handler.onStartObject();
+    handler.onKey(str);
+    handler.onEndObject();
+    handler.onStartList();
+    handler.onEndList();
+    handler.onString(str);
+    handler.onInt64(std::int64_t{});
+    handler.onUint64(std::uint64_t{});
+    handler.onDouble(double{});
+    handler.onRawNumber(str);
+    handler.onBool(bool{});
+    handler.onNull();
+};
+
+/***
+ * @param  json_str {std::string_view}: the json string, read only
+ * @param  handler {Handler}: gets the events in the order of the string
+ * @param  options {ParseOptions}: raw_number and structural_index apply,
+ * the others only matter to the tree
+ * @exception: std::invalid_argument if the string can't be parsed, the
+ * events before the error are already sent
+ * @description: no tree is built, this is what Parser uses underneath
+ ***/
+template < SaxHandler Handler >
+void saxParse(
+  std::string_view json_str, Handler& handler, ParseOptions options = {}) {
+    __detail::_ParserScan::_ScanContext ctx{options};
+    __detail::_ParserScan::scanDocument(json_str, ctx, handler);
+}
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_SAX_HPP__
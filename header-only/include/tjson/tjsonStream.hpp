@@ -0,0 +1,471 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-23T09:12:48
+ * @lastmod: 2024-07-23T09:12:48
+ * @description: a push parser, the json string is fed chunk by chunk
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonStream.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_STREAM_HPP__
+#define __TJSON_STREAM_HPP__
+
+#include <algorithm>
+#include <concepts>
+#include <format>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/detail/_SimdScan.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+#include "tjson/tjsonSax.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+/***
+ * @description: parse a json string given in chunks of any size, a chunk
+ * may end anywhere, even inside a string or a number. The handler gets the
+ * same events as saxParse as soon as a token is complete, and onEndValue()
+ * (if it has one) behind each root value, the stream may hold many root
+ * values separated by white space. Only the open containers and the token
+ * split by a chunk boundary are kept, so the memory is bounded by the
+ * nesting depth and not by the size of the stream.
+ ***/
+template < SaxHandler Handler >
+class StreamParser {
+  private:
+    // what the next token must be
+    enum class _Expect {
+        VALUE,        // a root value, or a value behind : or , in a list
+        VALUE_OR_END, // behind [
+        KEY_OR_END,   // behind {
+        KEY,          // behind , in an object
+        COLON,        // behind a key
+        COMMA_OR_END, // behind a value in a list or object
+    };
+
+    // the token the last chunk ended in
+    enum class _Partial { NONE, STRING, KEY, NUMBER, LITERAL };
+
+    Handler& m_handler;
+    __detail::_ParserScan::_ScanContext m_ctx;
+
+    // { or [ for each open container
+    std::vector< char > m_stack;
+    _Expect m_expect   = _Expect::VALUE;
+    _Partial m_partial = _Partial::NONE;
+
+    // the chars of the partial token read so far, a string is kept raw and
+    // decoded when it is complete
+    std::string m_token;
+    std::string_view m_literal;
+    // the partial string ends with a \ that escapes the next char
+    bool m_escape     = false;
+    bool m_has_escape = false;
+    // a root number or literal needs white space before the next root
+    bool m_glued = false;
+
+    // where the token begins in the stream, and how much was fed before
+    // the current chunk, only used to report the error position
+    std::size_t m_token_begin = 0;
+    std::size_t m_offset      = 0;
+
+    [[noreturn]] void unexpected(char ch, std::size_t pos) const {
+        throw std::invalid_argument(
+          std::format("\033[1;31munexpected character {} at {}\033[0m", ch,
+            m_offset + pos));
+    }
+
+    void valueDone() {
+        if (!m_stack.empty()) {
+            m_expect = _Expect::COMMA_OR_END;
+            return;
+        }
+        m_expect = _Expect::VALUE;
+        if constexpr (requires { m_handler.onEndValue(); }) {
+            m_handler.onEndValue();
+        }
+    }
+
+    void closeContainer() {
+        char open = m_stack.back();
+        m_stack.pop_back();
+        if (open == '{') {
+            m_handler.onEndObject();
+        }
+        else {
+            m_handler.onEndList();
+        }
+        valueDone();
+    }
+
+    // chunk[begin] is inside the string body, return where to go on
+    std::size_t scanStringBody(std::string_view chunk, std::size_t begin) {
+        const char* const data = chunk.data();
+        const char* const end  = data + chunk.size();
+        const char* pos        = data + begin;
+        if (m_escape && pos < end) {
+            m_escape = false;
+            ++pos;
+        }
+        while (true) {
+            pos = __detail::_SimdScan::findStringSpecial(pos, end);
+            if (pos == end) {
+                m_token.append(data + begin, end);
+                return chunk.size();
+            }
+            if (*pos == '\"') {
+                std::string_view body{data + begin, pos};
+                // only copied if the string began in an earlier chunk
+                if (!m_token.empty()) {
+                    m_token.append(body);
+                    body = m_token;
+                }
+                finishString(body);
+                return pos - data + 1;
+            }
+            if (*pos == '\\') {
+                m_has_escape = true;
+                if (end - pos < 2) {
+                    m_escape = true;
+                    m_token.append(data + begin, end);
+                    return chunk.size();
+                }
+                pos += 2; // the escaped char is checked when decoding
+                continue;
+            }
+            throw std::invalid_argument(
+              std::format("\033[1;31mcontrol char must be escaped in json "
+                          "string at {}\033[0m",
+                m_offset + (pos - data)));
+        }
+    }
+
+    void finishString(std::string_view body) {
+        bool is_key = m_partial == _Partial::KEY;
+        m_partial   = _Partial::NONE;
+        if (m_has_escape) {
+            m_ctx.scratch.clear();
+            __detail::_ParserScan::escapeString(
+              body, m_ctx.scratch, m_token_begin);
+            body = m_ctx.scratch;
+        }
+        if (is_key) {
+            m_handler.onKey(body);
+            m_expect = _Expect::COLON;
+            return;
+        }
+        m_handler.onString(body);
+        valueDone();
+    }
+
+    static bool isNumberChar(char ch) {
+        return __detail::_ParserScan::isDigit(ch) || ch == '-' || ch == '+'
+            || ch == '.' || ch == 'e' || ch == 'E';
+    }
+
+    std::size_t scanNumberBody(std::string_view chunk, std::size_t begin) {
+        std::size_t pos = begin;
+        while (pos < chunk.size() && isNumberChar(chunk[pos])) ++pos;
+        if (pos == chunk.size()) {
+            // more digits may come with the next chunk
+            m_token.append(chunk.substr(begin));
+            return pos;
+        }
+        std::string_view body = chunk.substr(begin, pos - begin);
+        if (!m_token.empty()) {
+            m_token.append(body);
+            body = m_token;
+        }
+        finishNumber(body);
+        return pos;
+    }
+
+    void finishNumber(std::string_view body) {
+        m_partial = _Partial::NONE;
+        std::size_t reads = 0;
+        __detail::_ParserScan::_NumberSpan span{};
+        try {
+            span = __detail::_ParserScan::scanNumber(body, reads);
+        } catch (const std::invalid_argument&) {
+            reads = 0;
+        }
+        if (reads != body.size()) {
+            throw std::invalid_argument(
+              std::format("\033[1;31minvalid json number {} at {}\033[0m",
+                body, m_token_begin));
+        }
+        __detail::_ParserScan::emitNumber(
+          span, m_token_begin, m_ctx, m_handler);
+        m_glued = m_stack.empty();
+        valueDone();
+    }
+
+    std::size_t scanLiteralBody(std::string_view chunk, std::size_t begin) {
+        std::size_t matched = m_token.size();
+        std::size_t count =
+          std::min(m_literal.size() - matched, chunk.size() - begin);
+        if (chunk.substr(begin, count) != m_literal.substr(matched, count)) {
+            throw std::invalid_argument(
+              std::format("\033[1;31mjson literal at {} ,maybe you mean "
+                          "{}\033[0m",
+                m_token_begin, m_literal));
+        }
+        if (matched + count < m_literal.size()) {
+            m_token.append(chunk.substr(begin, count));
+            return chunk.size();
+        }
+        m_partial = _Partial::NONE;
+        if (m_literal == "null") {
+            m_handler.onNull();
+        }
+        else {
+            m_handler.onBool(m_literal == "true");
+        }
+        m_glued = m_stack.empty();
+        valueDone();
+        return begin + count;
+    }
+
+    // start the token at chunk[pos], return where to go on
+    std::size_t beginToken(
+      std::string_view chunk, std::size_t pos, _Partial partial) {
+        m_partial     = partial;
+        m_token_begin = m_offset + pos;
+        m_token.clear();
+        switch (partial) {
+            case _Partial::STRING:
+            case _Partial::KEY:
+                m_has_escape  = false;
+                m_escape      = false;
+                m_token_begin = m_offset + pos + 1;
+                return scanStringBody(chunk, pos + 1);
+            case _Partial::NUMBER:
+                return scanNumberBody(chunk, pos);
+            default:
+                return scanLiteralBody(chunk, pos);
+        }
+    }
+
+    std::size_t beginValue(std::string_view chunk, std::size_t pos) {
+        switch (chunk[pos]) {
+            case '{':
+                m_handler.onStartObject();
+                m_stack.push_back('{');
+                m_expect = _Expect::KEY_OR_END;
+                return pos + 1;
+            case '[':
+                m_handler.onStartList();
+                m_stack.push_back('[');
+                m_expect = _Expect::VALUE_OR_END;
+                return pos + 1;
+            case '\"':
+                return beginToken(chunk, pos, _Partial::STRING);
+            case 't':
+                m_literal = "true";
+                return beginToken(chunk, pos, _Partial::LITERAL);
+            case 'f':
+                m_literal = "false";
+                return beginToken(chunk, pos, _Partial::LITERAL);
+            case 'n':
+                m_literal = "null";
+                return beginToken(chunk, pos, _Partial::LITERAL);
+            default:
+                break;
+        }
+        if (chunk[pos] == '-' || __detail::_ParserScan::isDigit(chunk[pos])) {
+            return beginToken(chunk, pos, _Partial::NUMBER);
+        }
+        unexpected(chunk[pos], pos);
+    }
+
+    // go on with the token the last chunk ended in
+    std::size_t resume(std::string_view chunk) {
+        switch (m_partial) {
+            case _Partial::STRING:
+            case _Partial::KEY:
+                return scanStringBody(chunk, 0);
+            case _Partial::NUMBER:
+                return scanNumberBody(chunk, 0);
+            default:
+                return scanLiteralBody(chunk, 0);
+        }
+    }
+
+  public:
+    /***
+     * @param  handler {Handler}: gets the events, must outlive the parser
+     * @param  options {ParseOptions}: only raw_number applies
+     ***/
+    explicit StreamParser(Handler& handler, ParseOptions options = {})
+        : m_handler{handler}, m_ctx{options} {}
+
+    /***
+     * @param  chunk {std::string_view}: the next bytes of the stream, only
+     * read during the call
+     * @exception: std::invalid_argument if the stream can't be parsed
+     ***/
+    void feed(std::string_view chunk) {
+        std::size_t pos = 0;
+        if (m_partial != _Partial::NONE && !chunk.empty()) {
+            pos = resume(chunk);
+        }
+        while (pos < chunk.size()) {
+            char ch = chunk[pos];
+            if (__detail::_ParserScan::isWhiteSpace(ch)) {
+                m_glued = false;
+                ++pos;
+                continue;
+            }
+            switch (m_expect) {
+                case _Expect::COLON:
+                    if (ch != ':') {
+                        throw std::invalid_argument(std::format(
+                          "\033[1;31mexpect : at {}\033[0m", m_offset + pos));
+                    }
+                    ++pos;
+                    m_expect = _Expect::VALUE;
+                    break;
+                case _Expect::COMMA_OR_END:
+                    if (ch == ',') {
+                        ++pos;
+                        m_expect = m_stack.back() == '{' ? _Expect::KEY
+                                                         : _Expect::VALUE;
+                    }
+                    else if (ch == (m_stack.back() == '{' ? '}' : ']')) {
+                        ++pos;
+                        closeContainer();
+                    }
+                    else {
+                        unexpected(ch, pos);
+                    }
+                    break;
+                case _Expect::KEY_OR_END:
+                    if (ch == '}') {
+                        ++pos;
+                        closeContainer();
+                        break;
+                    }
+                    [[fallthrough]];
+                case _Expect::KEY:
+                    if (ch != '\"') {
+                        throw std::invalid_argument(std::format(
+                          "\033[1;31mexpect a string key at {}\033[0m",
+                          m_offset + pos));
+                    }
+                    pos = beginToken(chunk, pos, _Partial::KEY);
+                    break;
+                case _Expect::VALUE_OR_END:
+                    if (ch == ']') {
+                        ++pos;
+                        closeContainer();
+                        break;
+                    }
+                    [[fallthrough]];
+                case _Expect::VALUE:
+                    if (m_glued) {
+                        unexpected(ch, pos);
+                    }
+                    pos = beginValue(chunk, pos);
+                    break;
+            }
+        }
+        m_offset += chunk.size();
+    }
+
+    /***
+     * @description: read the stream until its end and finish it
+     * @param  is {std::istream}: e.g. std::cin or a std::ifstream
+     * @param  chunk_size {std::size_t}: how many bytes to read at once
+     ***/
+    void feed(std::istream& is, std::size_t chunk_size = 1 << 16) {
+        std::string chunk(chunk_size, '\0');
+        while (is.read(chunk.data(), chunk_size) || is.gcount() > 0) {
+            feed(std::string_view{chunk.data(),
+              static_cast< std::size_t >(is.gcount())});
+        }
+        finish();
+    }
+
+    /***
+     * @description: the end of the stream, a root number is only complete
+     * here if nothing follows it
+     * @exception: std::invalid_argument if the stream ends inside a value
+     ***/
+    void finish() {
+        if (m_partial == _Partial::NUMBER) {
+            finishNumber(m_token);
+        }
+        if (m_partial != _Partial::NONE || !m_stack.empty()) {
+            throw std::invalid_argument(std::format(
+              "\033[1;31mjson ends inside a value at {}\033[0m", m_offset));
+        }
+        m_glued = false;
+    }
+
+    // the depth of the open containers
+    std::size_t depth() const { return m_stack.size(); }
+};
+
+namespace __detail {
+
+// build each root value and give it to the callback
+template < typename Callback >
+class _ValueHandler : public _DomHandler {
+  private:
+    Callback m_callback;
+
+  public:
+    explicit _ValueHandler(Callback callback)
+        : _DomHandler{std::pmr::get_default_resource()},
+          m_callback{std::move(callback)} {}
+
+    void onEndValue() { m_callback(take()); }
+};
+
+} // namespace __detail
+
+/***
+ * @description: a StreamParser that builds each root value of the stream
+ * as a TJsonObj and gives it to the callback once it is complete, only one
+ * root value is kept at a time
+ * @example: ValueStreamParser values{[](TJsonObj&& obj) { obj.println(); }};
+ ***/
+template < std::invocable< TJsonObj&& > Callback >
+class ValueStreamParser {
+  private:
+    __detail::_ValueHandler< Callback > m_handler;
+    StreamParser< __detail::_ValueHandler< Callback > > m_parser;
+
+  public:
+    explicit ValueStreamParser(Callback callback, ParseOptions options = {})
+        : m_handler{std::move(callback)}, m_parser{m_handler, options} {}
+
+    // the handler is referred to by m_parser
+    ValueStreamParser(const ValueStreamParser&)            = delete;
+    ValueStreamParser& operator=(const ValueStreamParser&) = delete;
+
+    void feed(std::string_view chunk) { m_parser.feed(chunk); }
+
+    void feed(std::istream& is, std::size_t chunk_size = 1 << 16) {
+        m_parser.feed(is, chunk_size);
+    }
+
+    void finish() { m_parser.finish(); }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_STREAM_HPP__
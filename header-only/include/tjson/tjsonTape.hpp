@@ -0,0 +1,649 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-29T10:05:17
+ * @lastmod: 2024-07-29T10:05:17
+ * @description: a read only json document kept as one array of 16 bytes
+ * nodes, numbers inline and strings in one buffer
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonTape.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_TAPE_HPP__
+#define __TJSON_TAPE_HPP__
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "tjson/detail/_DomHandler.hpp"
+#include "tjson/detail/_KeyTable.hpp"
+#include "tjson/detail/_ParserScan.hpp"
+#include "tjson/detail/_Serializer.hpp"
+#include "tjson/tjsonObj.hpp"
+#include "tjson/tjsonOptions.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+/***
+ * @description: one value on the tape. A list or an object is followed by
+ * the nodes inside it, span tells how many, so it is skipped in one step.
+ * The members of an object are a STRING node of the key and then the value.
+ ***/
+struct TapeNode {
+    enum class Tag : std::uint8_t {
+        NUL,
+        BOOL,
+        INT64,
+        UINT64,
+        DOUBLE,
+        STRING,     // offset and size into the chars of the tape
+        RAW_NUMBER, // the text in source, like STRING
+        LIST,
+        DICT,
+    };
+
+    Tag tag;
+    // the chars of a string, the elements of a list or members of a dict
+    std::uint32_t size;
+
+    union {
+        bool boolean;
+        std::int64_t int64;
+        std::uint64_t uint64;
+        double number;
+        std::uint64_t offset; // STRING, RAW_NUMBER
+        std::uint64_t span;   // LIST, DICT
+    };
+
+    bool isContainer() const { return tag == Tag::LIST || tag == Tag::DICT; }
+
+    // the nodes this value takes, with the ones inside it
+    std::size_t width() const { return isContainer() ? span + 1 : 1; }
+};
+
+static_assert(sizeof(TapeNode) == 16);
+
+struct TapeMember;
+
+/***
+ * @description: a key looked up once by TJsonTape::key, to find it in many
+ * objects of the same tape. If the keys of the tape are interned, it is
+ * compared to the members by offset instead of by the chars. A key repeated
+ * in one object gives the last value either way.
+ ***/
+struct TapeKey {
+    std::string_view str;
+    // where the text is in the tape, npos if no member has it
+    std::uint64_t offset = __detail::_KeyTable::npos;
+    bool interned        = false;
+};
+
+namespace __detail {
+template < bool Members >
+class _TapeIter;
+
+template < bool Members >
+struct _TapeRange;
+} // namespace __detail
+
+// a view of one value on a TJsonTape, valid as long as the tape
+class TapeValue {
+  private:
+    using Tag = TapeNode::Tag;
+
+    const TapeNode* m_node;
+    const char* m_chars;
+
+    void expect(Tag tag, std::string_view what) const {
+        if (m_node->tag != tag) {
+            throw std::runtime_error(
+              std::format("\033[1;31mNot a {}, can't use {}\033[0m",
+                tag == Tag::LIST ? "ListType" : "DictType", what));
+        }
+    }
+
+    std::string_view chars() const {
+        return {m_chars + m_node->offset, m_node->size};
+    }
+
+    // the value of the member, nullptr if there is none. A repeated key
+    // takes the last value, as in the tree, so all members are looked at
+    const TapeNode* findMember(const TapeKey& key) const {
+        expect(Tag::DICT, "[]");
+        const TapeNode* node  = m_node + 1;
+        const TapeNode* end   = m_node + m_node->width();
+        const TapeNode* found = nullptr;
+        while (node != end) {
+            bool same = key.interned
+                        ? node->offset == key.offset
+                        : TapeValue{node, m_chars}.chars() == key.str;
+            if (same) {
+                found = node + 1;
+            }
+            node += 1 + node[1].width();
+        }
+        return found;
+    }
+
+    template < __detail::_Serializer::CharSink Sink >
+    static void write(Sink& sink, TapeValue value,
+      const FormatOptions& options, std::size_t depth);
+
+    template < typename Handler >
+    static void replay(TapeValue value, Handler& handler);
+
+  public:
+    TapeValue(const TapeNode* node, const char* chars)
+        : m_node{node}, m_chars{chars} {}
+
+    Tag tag() const { return m_node->tag; }
+
+    bool isNull() const { return tag() == Tag::NUL; }
+
+    bool isBool() const { return tag() == Tag::BOOL; }
+
+    bool isNumber() const {
+        return tag() == Tag::INT64 || tag() == Tag::UINT64 ||
+               tag() == Tag::DOUBLE || tag() == Tag::RAW_NUMBER;
+    }
+
+    bool isString() const { return tag() == Tag::STRING; }
+
+    bool isList() const { return tag() == Tag::LIST; }
+
+    bool isDict() const { return tag() == Tag::DICT; }
+
+    /**
+     * @brief: the value of a BOOL node
+     * @exception: std::runtime_error if not a bool
+     */
+    bool getBool() const {
+        if (!isBool()) {
+            throw std::runtime_error(
+              "\033[1;31mNot a bool, can't use getBool\033[0m");
+        }
+        return m_node->boolean;
+    }
+
+    /**
+     * @brief: the chars of a string, inside the tape
+     * @exception: std::runtime_error if not a string
+     */
+    std::string_view getString() const {
+        if (!isString()) {
+            throw std::runtime_error(
+              "\033[1;31mNot a string, can't use getString\033[0m");
+        }
+        return chars();
+    }
+
+    /**
+     * @brief: any kind of number as T, like TJsonObj::getNumber
+     * @exception: std::runtime_error if not a number or can't be converted
+     */
+    template < typename T >
+        requires std::is_arithmetic_v< T >
+    T getNumber() const {
+        switch (tag()) {
+            case Tag::INT64: return static_cast< T >(m_node->int64);
+            case Tag::UINT64: return static_cast< T >(m_node->uint64);
+            case Tag::DOUBLE: return static_cast< T >(m_node->number);
+            case Tag::RAW_NUMBER: {
+                std::string_view str = chars();
+                T value{};
+                auto end = str.data() + str.size();
+                auto res = std::from_chars(str.data(), end, value);
+                if (res.ec == std::errc() && res.ptr == end) {
+                    return value;
+                }
+                throw std::runtime_error(std::format(
+                  "\033[1;31m{} can't be converted\033[0m", str));
+            }
+            default:
+                throw std::runtime_error(
+                  "\033[1;31mNot a number, can't use getNumber\033[0m");
+        }
+    }
+
+    // the elements of a list or the members of a dict, 0 otherwise
+    std::size_t size() const {
+        return m_node->isContainer() ? m_node->size : 0;
+    }
+
+    /**
+     * @brief: the element at index, the elements before it are skipped
+     * @exception: std::runtime_error if not a list or out of range
+     */
+    TapeValue operator[](std::size_t index) const {
+        expect(Tag::LIST, "[]");
+        if (index >= m_node->size) {
+            throw std::runtime_error(
+              "\033[1;31mthe index is out of range\033[0m");
+        }
+        const TapeNode* node = m_node + 1;
+        for (; index > 0; --index) {
+            node += node->width();
+        }
+        return {node, m_chars};
+    }
+
+    /**
+     * @brief: the value of key, the members are searched in order
+     * @exception: std::runtime_error if not a dict or the key is not there
+     */
+    TapeValue operator[](std::string_view key) const {
+        return (*this)[TapeKey{key}];
+    }
+
+    // the key from TJsonTape::key of the same tape
+    TapeValue operator[](const TapeKey& key) const {
+        if (const TapeNode* node = findMember(key)) {
+            return {node, m_chars};
+        }
+        throw std::runtime_error("\033[1;31mkey not found\033[0m");
+    }
+
+    bool contains(std::string_view key) const {
+        return findMember(TapeKey{key}) != nullptr;
+    }
+
+    bool contains(const TapeKey& key) const {
+        return findMember(key) != nullptr;
+    }
+
+    // for (TapeValue element : value.items())
+    __detail::_TapeRange< false > items() const;
+
+    // for (auto [key, value] : value.members())
+    __detail::_TapeRange< true > members() const;
+
+    /**
+     * @brief: build a TJsonObj of this value
+     * @param  resource {std::pmr::memory_resource*}: where the tree is
+     * allocated, nullptr means the default resource
+     */
+    TJsonObj toObj(std::pmr::memory_resource* resource = nullptr) const {
+        __detail::_DomHandler dom{
+          resource ? resource : std::pmr::get_default_resource()};
+        replay(*this, dom);
+        return dom.take();
+    }
+
+    // the json text, laid out like TJsonObj::toString
+    std::string toString(const FormatOptions& options = {}) const {
+        std::string res;
+        dumpTo(res, options);
+        return res;
+    }
+
+    template < __detail::_Serializer::CharSink Sink >
+    void dumpTo(Sink& sink, const FormatOptions& options = {}) const {
+        write(sink, *this, options, 0);
+    }
+};
+
+// a member of a dict on the tape
+struct TapeMember {
+    std::string_view key;
+    TapeValue value;
+};
+
+namespace __detail {
+
+// walk the elements, or the key nodes of the members if Members is set
+template < bool Members >
+class _TapeIter {
+  private:
+    const TapeNode* m_node;
+    const char* m_chars;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::conditional_t< Members, TapeMember, TapeValue >;
+    using difference_type = std::ptrdiff_t;
+
+    _TapeIter() = default;
+
+    _TapeIter(const TapeNode* node, const char* chars)
+        : m_node{node}, m_chars{chars} {}
+
+    value_type operator*() const {
+        if constexpr (Members) {
+            return TapeMember{TapeValue{m_node, m_chars}.getString(),
+              TapeValue{m_node + 1, m_chars}};
+        }
+        else {
+            return TapeValue{m_node, m_chars};
+        }
+    }
+
+    _TapeIter& operator++() {
+        if constexpr (Members) {
+            ++m_node;
+        }
+        m_node += m_node->width();
+        return *this;
+    }
+
+    _TapeIter operator++(int) {
+        _TapeIter old = *this;
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const _TapeIter& other) const {
+        return m_node == other.m_node;
+    }
+};
+
+template < bool Members >
+struct _TapeRange {
+    _TapeIter< Members > first;
+    _TapeIter< Members > last;
+
+    _TapeIter< Members > begin() const { return first; }
+
+    _TapeIter< Members > end() const { return last; }
+};
+
+} // namespace __detail
+
+inline __detail::_TapeRange< false > TapeValue::items() const {
+    expect(Tag::LIST, "items");
+    return {{m_node + 1, m_chars}, {m_node + m_node->width(), m_chars}};
+}
+
+inline __detail::_TapeRange< true > TapeValue::members() const {
+    expect(Tag::DICT, "members");
+    return {{m_node + 1, m_chars}, {m_node + m_node->width(), m_chars}};
+}
+
+// the sax events of the value, in the order of the source
+template < typename Handler >
+void TapeValue::replay(TapeValue value, Handler& handler) {
+    switch (value.tag()) {
+        case Tag::NUL: handler.onNull(); break;
+        case Tag::BOOL: handler.onBool(value.m_node->boolean); break;
+        case Tag::INT64: handler.onInt64(value.m_node->int64); break;
+        case Tag::UINT64: handler.onUint64(value.m_node->uint64); break;
+        case Tag::DOUBLE: handler.onDouble(value.m_node->number); break;
+        case Tag::STRING: handler.onString(value.chars()); break;
+        case Tag::RAW_NUMBER: handler.onRawNumber(value.chars()); break;
+        case Tag::LIST:
+            handler.onStartList();
+            for (TapeValue element : value.items()) {
+                replay(element, handler);
+            }
+            handler.onEndList();
+            break;
+        case Tag::DICT:
+            handler.onStartObject();
+            for (auto member : value.members()) {
+                handler.onKey(member.key);
+                replay(member.value, handler);
+            }
+            handler.onEndObject();
+            break;
+    }
+}
+
+template < __detail::_Serializer::CharSink Sink >
+void TapeValue::write(Sink& sink, TapeValue value,
+  const FormatOptions& options, std::size_t depth) {
+    using namespace __detail::_Serializer;
+    auto string = [&](std::string_view str) {
+        if (options.ascii_only) {
+            writeStringAscii(sink, str);
+        }
+        else {
+            writeString(sink, str);
+        }
+    };
+    auto close = [&](char ch) {
+        if (options.indent > 0 && !options.compact) {
+            newLine(sink, options, depth);
+        }
+        sink.push_back(ch);
+    };
+    switch (value.tag()) {
+        case Tag::NUL: writeRaw(sink, "null"); break;
+        case Tag::BOOL:
+            writeRaw(sink, value.m_node->boolean ? "true" : "false");
+            break;
+        case Tag::INT64: writeNumber(sink, value.m_node->int64); break;
+        case Tag::UINT64: writeNumber(sink, value.m_node->uint64); break;
+        case Tag::DOUBLE: writeNumber(sink, value.m_node->number); break;
+        case Tag::STRING: string(value.chars()); break;
+        case Tag::RAW_NUMBER: writeRaw(sink, value.chars()); break;
+        case Tag::LIST: {
+            if (value.size() == 0) {
+                writeRaw(sink, "[]");
+                break;
+            }
+            sink.push_back('[');
+            bool first = true;
+            for (TapeValue element : value.items()) {
+                beforeElement(sink, options, depth, first);
+                first = false;
+                write(sink, element, options, depth + 1);
+            }
+            close(']');
+            break;
+        }
+        case Tag::DICT: {
+            if (value.size() == 0) {
+                writeRaw(sink, "{}");
+                break;
+            }
+            std::vector< TapeMember > members;
+            members.reserve(value.size());
+            for (auto member : value.members()) {
+                members.push_back(member);
+            }
+            if (options.sort_keys) {
+                std::sort(members.begin(), members.end(),
+                  [](const auto& lhs, const auto& rhs) {
+                      return lhs.key < rhs.key;
+                  });
+            }
+            sink.push_back('{');
+            bool first = true;
+            for (const auto& member : members) {
+                beforeElement(sink, options, depth, first);
+                first = false;
+                string(member.key);
+                writeRaw(sink, options.compact ? ":" : ": ");
+                write(sink, member.value, options, depth + 1);
+            }
+            close('}');
+            break;
+        }
+    }
+}
+
+/***
+ * @description: a read only document in two arrays, the 16 bytes nodes in
+ * the order of the source and the chars of every string and key. A list of
+ * numbers costs 16 bytes per element, against sizeof(TJsonObj) and the
+ * allocations of the tree. Use it to keep a large document in memory and
+ * read it, TapeValue::toObj gives a TJsonObj to change.
+ * @example:
+ *   TJsonTape tape{R"({"ids": [1, 2, 3]})"};
+ *   for (TapeValue id : tape.root()["ids"].items()) {
+ *       id.getNumber< int >();
+ *   }
+ ***/
+class TJsonTape {
+  private:
+    using Tag = TapeNode::Tag;
+
+    std::pmr::vector< TapeNode > m_nodes;
+    std::pmr::string m_chars;
+    // the keys if ParseOptions::intern_keys is set
+    __detail::_KeyTable m_keys;
+    bool m_interned = false;
+
+    // build the tape from the sax events
+    struct _Builder {
+        TJsonTape& tape;
+        // the open lists and dicts
+        std::vector< std::size_t > open;
+
+        static std::uint32_t checkSize(std::size_t size) {
+            if (size > std::numeric_limits< std::uint32_t >::max()) {
+                throw std::invalid_argument(
+                  "\033[1;31mtoo large for a tape node\033[0m");
+            }
+            return static_cast< std::uint32_t >(size);
+        }
+
+        TapeNode& push(Tag tag) {
+            if (!open.empty()) {
+                TapeNode& parent = tape.m_nodes[open.back()];
+                if (parent.tag == Tag::LIST) {
+                    parent.size = checkSize(parent.size + std::size_t{1});
+                }
+            }
+            TapeNode& node = tape.m_nodes.emplace_back();
+            node.tag       = tag;
+            node.size      = 0;
+            node.uint64    = 0;
+            return node;
+        }
+
+        void pushChars(TapeNode& node, std::string_view str) {
+            node.size   = checkSize(str.size());
+            node.offset = tape.m_chars.size();
+            tape.m_chars.append(str);
+        }
+
+        void start(Tag tag) {
+            push(tag);
+            open.push_back(tape.m_nodes.size() - 1);
+        }
+
+        void end() {
+            std::size_t index         = open.back();
+            tape.m_nodes[index].span = tape.m_nodes.size() - index - 1;
+            open.pop_back();
+        }
+
+        void onStartObject() { start(Tag::DICT); }
+
+        void onKey(std::string_view key) {
+            TapeNode& parent = tape.m_nodes[open.back()];
+            parent.size      = checkSize(parent.size + std::size_t{1});
+            TapeNode& node   = tape.m_nodes.emplace_back();
+            node.tag         = Tag::STRING;
+            if (tape.m_interned) {
+                node.size   = checkSize(key.size());
+                node.offset = tape.m_keys.intern(key, tape.m_chars);
+            }
+            else {
+                pushChars(node, key);
+            }
+        }
+
+        void onEndObject() { end(); }
+
+        void onStartList() { start(Tag::LIST); }
+
+        void onEndList() { end(); }
+
+        void onString(std::string_view str) {
+            pushChars(push(Tag::STRING), str);
+        }
+
+        void onInt64(std::int64_t value) { push(Tag::INT64).int64 = value; }
+
+        void onUint64(std::uint64_t value) {
+            push(Tag::UINT64).uint64 = value;
+        }
+
+        void onDouble(double value) { push(Tag::DOUBLE).number = value; }
+
+        void onRawNumber(std::string_view str) {
+            pushChars(push(Tag::RAW_NUMBER), str);
+        }
+
+        void onBool(bool value) { push(Tag::BOOL).boolean = value; }
+
+        void onNull() { push(Tag::NUL); }
+    };
+
+  public:
+    TJsonTape() = default;
+
+    /***
+     * @param  json_str {std::string_view}: the json string, it is not kept
+     * @param  options {ParseOptions}: raw_number, structural_index and
+     * resource apply, the strings are always copied into the tape
+     * @exception: std::invalid_argument if the string can't be parsed
+     ***/
+    explicit TJsonTape(std::string_view json_str, ParseOptions options = {})
+        : m_nodes{options.resource ? options.resource
+                                   : std::pmr::get_default_resource()},
+          m_chars{m_nodes.get_allocator()},
+          m_keys{m_nodes.get_allocator().resource()},
+          m_interned{options.intern_keys} {
+        __detail::_ParserScan::_ScanContext ctx{options};
+        _Builder builder{*this};
+        __detail::_ParserScan::scanDocument(json_str, ctx, builder);
+        // the growth of the vectors is given back
+        m_nodes.shrink_to_fit();
+        m_chars.shrink_to_fit();
+    }
+
+    /**
+     * @brief: the root value
+     * @exception: std::runtime_error if nothing is parsed
+     */
+    TapeValue root() const {
+        if (m_nodes.empty()) {
+            throw std::runtime_error("\033[1;31mthe tape is empty\033[0m");
+        }
+        return {m_nodes.data(), m_chars.data()};
+    }
+
+    std::size_t nodeCount() const { return m_nodes.size(); }
+
+    // the bytes held by the nodes, the chars and the key table
+    std::size_t memoryBytes() const {
+        return m_nodes.capacity() * sizeof(TapeNode) + m_chars.capacity()
+             + m_keys.memoryBytes();
+    }
+
+    /**
+     * @brief: look up key once to find it in many objects of this tape,
+     * with ParseOptions::intern_keys it is then compared by offset
+     * @example:
+     *   TapeKey id = tape.key("id");
+     *   for (TapeValue record : tape.root().items()) {
+     *       record[id].getNumber< int >();
+     *   }
+     */
+    TapeKey key(std::string_view key) const {
+        if (!m_interned) {
+            return TapeKey{key};
+        }
+        return TapeKey{key, m_keys.find(key, m_chars), true};
+    }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_TAPE_HPP__
@@ -0,0 +1,294 @@
+/**
+ * @author: Laplace825
+ * @date: 2024-07-27T11:06:52
+ * @lastmod: 2024-07-27T11:06:52
+ * @description: write json token by token without building a TJsonObj
+ * @filePath: /cpp-tiny-json/header-only/include/tjson/tjsonWriter.hpp
+ * @lastEditor: Laplace825
+ * @ MIT license
+ */
+
+#ifndef __TJSON_WRITER_HPP__
+#define __TJSON_WRITER_HPP__
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tjson/detail/_Serializer.hpp"
+#include "tjson/tjsonObj.hpp"
+
+namespace lap {
+
+namespace tjson {
+
+// where a Writer flushes its buffer
+template < typename Sink >
+concept WriteSink = requires(Sink& sink, const char* str, std::size_t size) {
+    sink.write(str, size);
+};
+
+// write to a FILE*, it is not closed
+class FileSink {
+  private:
+    std::FILE* m_file;
+
+  public:
+    explicit FileSink(std::FILE* file) : m_file{file} {}
+
+    void write(const char* str, std::size_t size) {
+        if (std::fwrite(str, 1, size, m_file) != size) {
+            throw std::runtime_error(
+              "\033[1;31mfailed to write the json to the file\033[0m");
+        }
+    }
+};
+
+#if __has_include(<unistd.h>)
+// write to a file descriptor, it is not closed
+class FdSink {
+  private:
+    int m_fd;
+
+  public:
+    explicit FdSink(int fd) : m_fd{fd} {}
+
+    void write(const char* str, std::size_t size) {
+        while (size > 0) {
+            ssize_t count = ::write(m_fd, str, size);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(
+                  "\033[1;31mfailed to write the json to the fd\033[0m");
+            }
+            str += count;
+            size -= count;
+        }
+    }
+};
+#endif
+
+// append to the caller's string
+class StringSink {
+  private:
+    std::string* m_str;
+
+  public:
+    explicit StringSink(std::string& str) : m_str{&str} {}
+
+    void write(const char* str, std::size_t size) { m_str->append(str, size); }
+};
+
+/***
+ * @description: write json straight to the sink, the text is gathered in a
+ * buffer of a fixed size and flushed when it is full, so the memory does
+ * not grow with the output. Many root values are put on their own lines.
+ * @example:
+ *   Writer writer{FileSink{stdout}};
+ *   writer.startObject();
+ *   writer.key("id");
+ *   writer.value(1);
+ *   writer.endObject();
+ ***/
+template < WriteSink Sink >
+class Writer {
+  private:
+    // an open list or object
+    struct _Level {
+        bool is_object;
+        bool first   = true;
+        bool has_key = false; // the key of the next value is written
+    };
+
+    // what _Serializer writes to
+    struct _Out {
+        Writer* writer;
+
+        void append(const char* str, std::size_t size) {
+            writer->append(str, size);
+        }
+
+        void push_back(char ch) { writer->append(&ch, 1); }
+    };
+
+    Sink m_sink;
+    std::string m_buffer;
+    std::size_t m_capacity;
+    std::vector< _Level > m_levels;
+    std::size_t m_roots = 0;
+
+    void append(const char* str, std::size_t size) {
+        if (m_buffer.size() + size > m_capacity) {
+            flushBuffer();
+            if (size > m_capacity) {
+                m_sink.write(str, size);
+                return;
+            }
+        }
+        m_buffer.append(str, size);
+    }
+
+    void append(std::string_view str) { append(str.data(), str.size()); }
+
+    void flushBuffer() {
+        if (!m_buffer.empty()) {
+            m_sink.write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+
+    [[noreturn]] static void misuse(std::string_view what) {
+        throw std::runtime_error(
+          std::format("\033[1;31mWriter: {}\033[0m", what));
+    }
+
+    // the separator before a value, and check a value is allowed here
+    void beforeValue() {
+        if (m_levels.empty()) {
+            if (m_roots++ > 0) {
+                append("\n", 1);
+            }
+            return;
+        }
+        _Level& level = m_levels.back();
+        if (level.is_object) {
+            if (!level.has_key) {
+                misuse("a value in an object needs a key first");
+            }
+            level.has_key = false;
+            return;
+        }
+        if (!level.first) {
+            append(", ");
+        }
+        level.first = false;
+    }
+
+    void endLevel(bool is_object) {
+        if (m_levels.empty() || m_levels.back().is_object != is_object) {
+            misuse(is_object ? "endObject without startObject"
+                             : "endList without startList");
+        }
+        if (m_levels.back().has_key) {
+            misuse("a key without a value");
+        }
+        m_levels.pop_back();
+        append(is_object ? "}" : "]");
+    }
+
+  public:
+    /***
+     * @param  sink {Sink}: FileSink, FdSink, StringSink, or any type with
+     * write(const char*, std::size_t)
+     * @param  buffer_size {std::size_t}: the bytes kept before a flush
+     ***/
+    explicit Writer(Sink sink, std::size_t buffer_size = 1 << 16)
+        : m_sink{std::move(sink)}, m_capacity{buffer_size} {
+        m_buffer.reserve(m_capacity);
+    }
+
+    // the rest of the buffer is flushed, an error here can't be reported
+    ~Writer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    Writer(const Writer&)            = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void startObject() {
+        beforeValue();
+        m_levels.push_back(_Level{true});
+        append("{");
+    }
+
+    void endObject() { endLevel(true); }
+
+    void startList() {
+        beforeValue();
+        m_levels.push_back(_Level{false});
+        append("[");
+    }
+
+    void endList() { endLevel(false); }
+
+    void key(std::string_view key) {
+        if (m_levels.empty() || !m_levels.back().is_object ||
+            m_levels.back().has_key)
+        {
+            misuse("a key is only allowed in an object before a value");
+        }
+        _Level& level = m_levels.back();
+        if (!level.first) {
+            append(", ");
+        }
+        level.first   = false;
+        level.has_key = true;
+        _Out out{this};
+        __detail::_Serializer::writeString(out, key);
+        append(": ");
+    }
+
+    void value(std::string_view str) {
+        beforeValue();
+        _Out out{this};
+        __detail::_Serializer::writeString(out, str);
+    }
+
+    void value(const char* str) { value(std::string_view{str}); }
+
+    void value(const std::string& str) { value(std::string_view{str}); }
+
+    void value(bool boolean) {
+        beforeValue();
+        append(boolean ? "true" : "false");
+    }
+
+    void value(std::nullptr_t) {
+        beforeValue();
+        append("null");
+    }
+
+    template < typename T >
+        requires std::is_arithmetic_v< T > && (!std::is_same_v< T, bool >)
+    void value(T number) {
+        beforeValue();
+        _Out out{this};
+        __detail::_Serializer::writeNumber(out, number);
+    }
+
+    // a whole tree, written like TJsonObj::toString
+    void value(const TJsonObj& obj) {
+        beforeValue();
+        _Out out{this};
+        __detail::_Serializer::writeValue(out, obj);
+    }
+
+    // give the buffered text to the sink
+    void flush() { flushBuffer(); }
+
+    // true if every list and object is closed
+    bool complete() const { return m_levels.empty(); }
+};
+
+} // namespace tjson
+
+} // namespace lap
+
+#endif // __TJSON_WRITER_HPP__
@@ -10,8 +10,46 @@
 
 #include <tjson.hpp>
 #include <tjson/tjfile.hpp>
+#include <tjson/tjsonNdjson.hpp>
 #include <tjson/tjprint.hpp>
 
+// count the allocations of the default resource
+class AllocationCounter : public std::pmr::memory_resource {
+  public:
+    std::size_t count = 0;
+
+  private:
+    void* do_allocate(std::size_t size, std::size_t align) override {
+        ++count;
+        return std::pmr::new_delete_resource()->allocate(size, align);
+    }
+
+    void do_deallocate(
+      void* ptr, std::size_t size, std::size_t align) override {
+        std::pmr::new_delete_resource()->deallocate(ptr, size, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// read and written without a tree
+struct Score {
+    std::string subject;
+    double value = 0;
+};
+TJSON_FIELDS(Score, subject, value)
+
+struct Student {
+    int id = 0;
+    std::string name;
+    std::vector< Score > scores;
+    std::optional< bool > graduated;
+    lap::tjson::TJsonObj extra;
+};
+TJSON_FIELDS(Student, id, name, scores, graduated, extra)
+
 auto main() -> signed {
     using namespace lap::tjson;
     try {
@@ -22,7 +60,7 @@ auto main() -> signed {
         TJson tj;
         std::cout
           << "\033[1;32m>>> set the json string to json object\033[0m\n";
-        tj.setJsonStr(tjf.getJsonStr());
+        tj.setJsonView(tjf.getJsonView());
         tjf.dumpJsonObj2File(tj, "./testDump.json");
 
         std::cout << "\033[1;32m>>> print the json object\033[0m\n";
@@ -44,6 +82,12 @@ auto main() -> signed {
             iter->second.println();
         }
 
+        std::cout << "\033[1;32m>>> look up with an index\033[0m\n";
+        tj.useIndex();
+        const TJson& indexed = tj;
+        std::cout << indexed.find("lop") << ' ' << indexed.at("/list/5/lop")
+                  << ' ' << indexed.at("/score/English") << '\n';
+
         std::cout << "\033[1;32m>>> change the json object\033[0m\n";
         std::cout << "\033[1;32mmake student to a dict\n"
                      "make \"lop\" to \"hl\"\033[0m\n"
@@ -54,9 +98,296 @@ auto main() -> signed {
         };
         tj.find("lop") = "hl";
         tj["list"][3]  = "chage] here";
+        // "li" is not in the index, it is under a changed value
+        std::cout << indexed.find("li") << ' ' << indexed.at("/list/3") << ' '
+                  << tj.at("/score/math") << '\n';
         std::cout << tj << '\n';
         tjf.dumpJsonObj2File(tj, "./testDumpChange.json");
 
+        std::cout << "\033[1;32m>>> build without deep copies\033[0m\n";
+        {
+            TJsonObj::ListType names;
+            TJsonObj::ListType scores;
+            for (int i = 0; i < 100; ++i) {
+                names.emplace_back(std::format("no small string {:20}", i));
+                scores.emplace_back(i);
+            }
+            TJsonObj::DictType members;
+            members.reserve(4);
+
+            AllocationCounter counter;
+            auto* previous = std::pmr::set_default_resource(&counter);
+            TJsonObj list{std::move(names)};
+            TJsonObj doc{std::move(members)};
+            doc.try_emplace("names", std::move(list));
+            doc["scores"] = std::move(scores);
+            doc["names"].emplace_back(TJsonObj::ListType{});
+            TJsonObj moved;
+            moved = std::move(doc);
+            std::size_t moves = counter.count;
+            TJsonObj copy;
+            copy = moved;
+            std::pmr::set_default_resource(previous);
+            std::cout << "allocations to move: " << moves
+                      << ", to copy: " << counter.count - moves << '\n';
+        }
+
+        std::cout << "\033[1;32m>>> parse into an arena\033[0m\n";
+        tjf.readJsonFile("./test.json");
+        Parser arena_parser(tjf.getJsonStr(), ParseOptions{.arena = true});
+        arena_parser.get().println();
+        {
+            Parser other(R"({"other": [1, "arena"]})",
+              ParseOptions{.arena = true});
+            other = std::move(arena_parser);
+            arena_parser = Parser(R"(["back"])", ParseOptions{.arena = true});
+            std::cout << other.get().at("/name") << ' ' << arena_parser.get()
+                      << '\n';
+            arena_parser = std::move(other);
+        }
+        {
+            // the values set later are on the heap, freed with the tree
+            TJson arena_tj{tjf.getJsonStr(), ParseOptions{.arena = true}};
+            arena_tj["name"] = TJsonObj::ListType{"set", "on", "the", "heap"};
+            std::cout << arena_tj.at("/name") << '\n';
+            arena_tj.setJsonStr(tjf.getJsonStr(), ParseOptions{.arena = true});
+            arena_tj["name"] = TJsonObj::DictType{{"heap", true}};
+        }
+
+        std::cout << "\033[1;32m>>> two stage parse\033[0m\n";
+        Parser two_stage(
+          tjf.getJsonStr(), ParseOptions{.structural_index = true});
+        std::cout << std::boolalpha
+                  << (two_stage.get() == arena_parser.get()) << '\n';
+
+        std::cout << "\033[1;32m>>> store the file as read\033[0m\n";
+        tjf.storeJsonStr2Where("./testStore.json");
+        {
+            TJsonFile stored;
+            stored.readJsonFile("./testStore.json");
+            std::cout << (stored.getJsonView() == tjf.getJsonView()) << ' '
+                      << (TJson{stored.getJsonStr()}.toString()
+                           == TJson{tjf.getJsonStr()}.toString())
+                      << '\n';
+        }
+
+        std::cout << "\033[1;32m>>> parse on many threads\033[0m\n";
+        {
+            std::string many = "[";
+            for (int i = 0; i < 50000; ++i) {
+                many.append(std::format(
+                  "{}{{\"id\": {}, \"name\": \"a, [b]\\\"\", \"x\": [{}]}}",
+                  i ? ", " : "", i, i * 0.5));
+            }
+            many.append("]");
+            Parser serial(many);
+            Parser parallel(many, ParseOptions{.threads = 4});
+            std::cout << (serial.get() == parallel.get()) << ' '
+                      << parallel.get().at("/49999/id") << '\n';
+            // a root closed by the other bracket fails as on one thread
+            std::string mismatched = many;
+            mismatched.back()      = '}';
+            for (std::size_t threads : {1, 4}) {
+                try {
+                    Parser bad(mismatched, ParseOptions{.threads = threads});
+                    std::cout << "parsed on " << threads << " threads\n";
+                } catch (const std::invalid_argument& e) {
+                    std::cout << threads << ": " << e.what() << '\n';
+                }
+            }
+            many.insert(many.find(", {", many.size() / 2) + 1, " tru,");
+            try {
+                Parser broken(many, ParseOptions{.threads = 4});
+            } catch (const std::invalid_argument& e) {
+                std::cout << e.what() << '\n';
+            }
+        }
+
+        std::cout << "\033[1;32m>>> borrow strings from the source\033[0m\n";
+        const std::string source = tjf.getJsonStr();
+        TJson insitu;
+        insitu.setJsonView(source, ParseOptions{.insitu = true});
+        insitu.println();
+
+        std::cout << "\033[1;32m>>> decode escapes\033[0m\n";
+        TJson escaped(
+          R"({"text": "tab\there \"quoted\" \u00e9 \ud83d\ude00"})");
+        std::cout << escaped["text"].getString() << '\n';
+
+        std::cout << "\033[1;32m>>> dump escapes and doubles\033[0m\n";
+        TJsonObj dumped{TJsonObj::ListType{
+          "line\nbreak \"quoted\"", 0.1 + 0.2, 2.5, 1e300}};
+        std::cout << dumped.toString() << '\n';
+
+        std::cout << "\033[1;32m>>> dump on many threads\033[0m\n";
+        {
+            TJsonObj::ListType rows;
+            for (int i = 0; i < 20000; ++i) {
+                TJsonObj row = TJsonObj::DictType{};
+                row.try_emplace("id", i);
+                row.try_emplace("tags", TJsonObj::ListType{"a", i * 0.5});
+                rows.push_back(std::move(row));
+            }
+            TJsonObj doc = TJsonObj::DictType{};
+            doc.try_emplace("rows", std::move(rows));
+            doc.try_emplace("name", "big");
+            TJson big(doc.toString());
+            bool same = true;
+            for (FormatOptions options :
+              {FormatOptions{}, FormatOptions{.indent = 2, .sort_keys = true},
+                FormatOptions{.compact = true}})
+            {
+                std::string serial = big.toString(options);
+                options.threads    = 4;
+                same = same && big.toString(options) == serial &&
+                       doc.toString(options) ==
+                         doc.toString({.indent = options.indent,
+                           .compact   = options.compact,
+                           .sort_keys = options.sort_keys});
+            }
+            std::cout << same << ' ' << big.toString({.threads = 4}).size()
+                      << '\n';
+        }
+
+        std::cout << "\033[1;32m>>> format options\033[0m\n";
+        TJson formatted(R"({"b": [1, {}], "a": "caf\u00e9 \ud83d\ude00"})");
+        formatted.println(FormatOptions{.compact = true, .sort_keys = true});
+        formatted.println(
+          FormatOptions{.indent = 2, .sort_keys = true, .ascii_only = true});
+
+        std::cout << "\033[1;32m>>> keep the order of the keys\033[0m\n";
+        TJsonObj::DictType keys{
+          {"z", 1},
+          {"y", 2}
+        };
+        for (int i = 0; i < 10; ++i) {
+            keys[TJsonObj::StringType{std::format("k{}", i)}] = i;
+        }
+        keys.erase("y");
+        keys["z"] = "still first";
+        TJsonObj{keys}.println();
+
+        std::cout << "\033[1;32m>>> a tape of 16 bytes nodes\033[0m\n";
+        TJsonTape tape{tjf.getJsonView()};
+        for (auto [key, value] : tape.root().members()) {
+            std::cout << key << ": " << value.toString() << '\n';
+        }
+        std::cout << tape.root()["list"][5]["lop"].getNumber< int >() << ' '
+                  << (tape.root().toObj() == two_stage.get()) << '\n';
+        TJsonTape records{R"([{"id": 1}, {"id": 2, "x": 0}, {"x": 0}])",
+          ParseOptions{.intern_keys = true}};
+        TapeKey id = records.key("id");
+        for (TapeValue record : records.root().items()) {
+            std::cout << (record.contains(id) ? record[id].toString() : "-")
+                      << ' ';
+        }
+        std::cout << tape.root().toObj()[HashedKey{"name"}] << '\n';
+        {
+            // a repeated key takes the last value in every document
+            const std::string_view twice = R"({"a": 1, "b": 0, "a": 2})";
+            TJsonTape dup{twice, ParseOptions{.intern_keys = true}};
+            std::cout << dup.root()["a"].toString() << ' '
+                      << dup.root()[dup.key("a")].toString() << ' '
+                      << dup.root().toObj()[HashedKey{"a"}] << ' '
+                      << LazyDocument{twice}["a"].raw() << '\n';
+        }
+
+        std::cout << "\033[1;32m>>> read on demand\033[0m\n";
+        LazyDocument lazy{tjf.getJsonView()};
+        std::cout << lazy["list"][5]["lop"].getNumber< int >() << ' '
+                  << lazy["name"].getString() << ' ' << lazy["list"].size()
+                  << ' ' << lazy["score"].raw() << '\n';
+        for (auto [key, value] : lazy.root().members()) {
+            std::cout << key << (value.isDict() ? " {} " : " ");
+        }
+        std::cout << (lazy.root().toObj() == two_stage.get()) << '\n';
+
+        std::cout << "\033[1;32m>>> write without a tree\033[0m\n";
+        std::string written;
+        {
+            Writer writer{StringSink{written}, 16};
+            writer.startObject();
+            writer.key("name");
+            writer.value("lap");
+            writer.key("scores");
+            writer.startList();
+            for (int score : {80, 90, 100}) {
+                writer.value(score);
+            }
+            writer.endList();
+            writer.key("tree");
+            writer.value(dumped);
+            writer.endObject();
+        }
+        std::cout << written << '\n';
+        tjf.writeJsonFile("./testWriter.json", [](auto& writer) {
+            writer.startList();
+            writer.value(nullptr);
+            writer.value(true);
+            writer.endList();
+        });
+
+        std::cout << "\033[1;32m>>> 64-bit and raw numbers\033[0m\n";
+        TJson nums(R"({"ts": 4294967296, "max": 18446744073709551615})");
+        nums.println();
+        TJson raw(R"({"id": 9007199254740993, "pi": 3.14159265358979323846})",
+          ParseOptions{.raw_number = true});
+        raw.println();
+        std::cout << raw["id"].getNumber< std::int64_t >() << '\n';
+
+        std::cout << "\033[1;32m>>> sax events without a tree\033[0m\n";
+        struct KeyPrinter : SaxHandlerBase {
+            void onKey(std::string_view key) { std::cout << key << ' '; }
+        } key_printer;
+        saxParse(tjf.getJsonView(), key_printer);
+        std::cout << '\n';
+
+        std::cout << "\033[1;32m>>> feed the json in chunks\033[0m\n";
+        ValueStreamParser values{[](TJsonObj&& obj) { obj.println(); }};
+        values.feed(R"({"chunk": "spl)");
+        values.feed(R"(it", "n": 12)");
+        values.feed(R"(34} [true, nu)");
+        values.feed("ll] 5");
+        values.finish();
+
+        std::cout << "\033[1;32m>>> read ndjson with a thread pool\033[0m\n";
+        NdjsonReader ndjson(2);
+        const std::string lines = "{\"id\": 1}\n\n[1, 2]\n{\"id\": }\n";
+        for (auto& record : ndjson.read(lines)) {
+            if (record.ok()) {
+                std::cout << record.line << ": " << record.value << '\n';
+            }
+            else {
+                std::cout << record.line << ": " << record.error << '\n';
+            }
+        }
+
+        std::cout << "\033[1;32m>>> json pointer\033[0m\n";
+        JsonPointer first_id{"/id"};
+        for (auto& record : ndjson.read(lines)) {
+            if (const TJsonObj* id = first_id.resolve(record.value)) {
+                std::cout << record.line << ": " << *id << '\n';
+            }
+        }
+        std::cout << tj.at("/list/5/lop") << ' '
+                  << two_stage.get().at("/score/math") << '\n';
+
+        std::cout << "\033[1;32m>>> map a struct to json\033[0m\n";
+        auto students = fromJson< std::vector< Student > >(R"([
+            {"id": 1, "name": "li \"x\"", "unknown": [1, {"a": null}],
+             "scores": [{"subject": "math", "value": 99.5}],
+             "graduated": null, "extra": {"any": [true]}},
+            {"name": "bai", "id": 2, "graduated": true}
+        ])");
+        std::cout << toJson(students) << '\n';
+        std::cout << toJson(students[1], {.indent = 2, .compact = true})
+                  << '\n';
+        try {
+            fromJson< Student >(R"({"id": 4294967296})");
+        } catch (const std::invalid_argument& e) {
+            std::cout << e.what() << '\n';
+        }
+
         std::cout
           << "\033[1;32mfind a can't find key in the json object\033[0m\n";
         tj.find("this will throw error");